@@ -0,0 +1,114 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/SpscRingBuffer.hpp>
+
+#include <yandex/contest/system/unistd/Descriptor.hpp>
+
+#include <bunsan/stream_enum.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Dump file written by a dedicated thread.
+ *
+ * Data is copied into a preallocated ring buffer,
+ * writer thread flushes everything accumulated with a single writev(2).
+ */
+class AsyncDump : private boost::noncopyable {
+ public:
+  BUNSAN_INCLASS_STREAM_ENUM_CLASS(OverflowPolicy, (
+    /// Wait for writer thread at most Options::maxStall, then TRUNCATE.
+    BLOCK,
+
+    /// Drop the rest of data and append TRUNCATION_MARKER.
+    TRUNCATE
+  ))
+
+  struct Options {
+    std::size_t bufferSize = 16 * 1024 * 1024;
+    OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK;
+
+    /// Longest single wait for free space, bounds execution loop stall.
+    std::chrono::milliseconds maxStall{1000};
+  };
+
+  struct Statistics {
+    std::uintmax_t bytes = 0;
+    std::uintmax_t writes = 0;
+
+    /// Time spent inside writev(2).
+    std::chrono::nanoseconds writeTime{0};
+
+    /// Time write() has waited for free space.
+    std::chrono::nanoseconds stallTime{0};
+
+    bool truncated = false;
+    bool failed = false;
+  };
+
+  static constexpr const char *TRUNCATION_MARKER = "\n[dump truncated]\n";
+
+ public:
+  AsyncDump(const boost::filesystem::path &path, const Options &options);
+
+  /// Write into already opened file.
+  AsyncDump(system::unistd::Descriptor file, const Options &options);
+
+  /// Calls close().
+  ~AsyncDump();
+
+  /// Called from single thread only.
+  void write(const char *data, std::size_t size);
+
+  /// No more data, waits for writer thread to complete.
+  void close();
+
+  /// Complete after close().
+  const Statistics &statistics() const { return statistics_; }
+
+ private:
+  void run();
+  void flush();
+  void notifyWriter();
+  void notifyProducer();
+
+ private:
+  const Options options_;
+  system::unistd::Descriptor file_;
+  SpscRingBuffer buffer_;
+
+  std::mutex lock_;
+  std::condition_variable dataReady_;
+  std::condition_variable spaceReady_;
+  std::atomic<bool> writerWaiting_{false};
+  std::atomic<bool> producerWaiting_{false};
+  std::atomic<bool> closed_{false};
+
+  bool truncated_ = false;
+  std::chrono::nanoseconds stallTime_{0};
+  Statistics statistics_;
+
+  std::thread thread_;
+};
+
+std::ostream &operator<<(std::ostream &out,
+                         const AsyncDump::Statistics &statistics);
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -1,14 +1,10 @@
 #pragma once
 
-#include <boost/version.hpp>
-#if BOOST_VERSION < 106100
-#define BOOST_NO_CXX11_VARIADIC_TEMPLATES
-#endif
-
 #include <yandex/contest/invoker/flowctl/interactive/BufferedWrapper.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/Event.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/SignalAdapter.hpp>
 
 #include <boost/bind.hpp>
-#include <boost/signals2.hpp>
 
 namespace yandex {
 namespace contest {
@@ -31,10 +27,12 @@ class StrandInject : public Parent {
 
 class BaseInterface : public detail::StrandInject<BufferedWrapper> {
  public:
-  using ErrorSignal = boost::signals2::signal<void(boost::system::error_code,
-                                                   std::size_t size)>;
-  using ErrorSlot = ErrorSignal::slot_type;
-  using ErrorExtendedSlot = ErrorSignal::extended_slot_type;
+  using ErrorSignal =
+      Event<void(boost::system::error_code, std::size_t size)>;
+  using ErrorSlot = ErrorSignal::Slot;
+
+  /// Connect with connectExtendedSlot().
+  using ErrorExtendedSlot = SignalTraits<ErrorSignal>::ExtendedSlot;
 
  public:
   BaseInterface(UnderlyingSource &underlyingSource,
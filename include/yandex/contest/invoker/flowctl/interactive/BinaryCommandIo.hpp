@@ -0,0 +1,67 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/CommandIo.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/CommandSet.hpp>
+
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*
+ * Binary command pack format.
+ *
+ * pack := MAGIC command* END
+ * command := code length value
+ *
+ * code is 1 + CommandSet::index(name) in a single byte, END is 0,
+ * length is unsigned LEB128 varint, value is raw bytes.
+ * MAGIC never starts text pack, so formats are told apart by first byte.
+ *
+ * Errors are reported as in allocation-free text interface,
+ * truncated pack is reported as CommandIoErrc::INSUFFICIENT_DATA.
+ */
+
+constexpr char BINARY_COMMAND_PACK_MAGIC = '\xBC';
+constexpr char BINARY_COMMAND_PACK_END = '\0';
+
+constexpr std::size_t MAX_VARINT_SIZE = 10;
+
+/// \return number of bytes written, at most MAX_VARINT_SIZE
+std::size_t encodeVarintTo(std::uint64_t value, char *out);
+
+/// \return number of consumed bytes
+std::size_t decodeVarint(StringRef data, std::uint64_t &value,
+                         boost::system::error_code &ec);
+
+inline bool isBinaryCommandPack(const StringRef data) {
+  return !data.empty() && data[0] == BINARY_COMMAND_PACK_MAGIC;
+}
+
+std::size_t maxEncodedBinaryCommandPackSize(const CommandSet &set);
+
+std::size_t encodeBinaryCommandPackTo(const CommandSet &set, char *out);
+
+void appendEncodedBinaryCommandPack(const CommandSet &set, std::string &out);
+
+/*!
+ * Set is replaced, capacity of its values is reused.
+ *
+ * \return number of consumed bytes; on CommandIoErrc::INSUFFICIENT_DATA
+ * the least data size which may be decoded further, so caller
+ * may wait for exactly that much data instead of decoding every byte.
+ */
+std::size_t decodeBinaryCommandPackTo(StringRef data, CommandSet &set,
+                                      boost::system::error_code &ec);
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
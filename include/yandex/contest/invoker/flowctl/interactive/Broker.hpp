@@ -13,6 +13,16 @@ namespace invoker {
 namespace flowctl {
 namespace interactive {
 
+/*!
+ * \brief Forwards whole delimiter-terminated messages.
+ *
+ * Each request (interactor > solution) is answered by
+ * RESPONSE_MULTIPLIER responses (solution > interactor)
+ * which are forwarded to interactor as a single batch.
+ * Interactor may pipeline requests without waiting for responses.
+ * Session completes when interactor closes its output
+ * at a request boundary and all responses are forwarded.
+ */
 class Broker : private boost::noncopyable {
  public:
   struct Options {
@@ -24,11 +34,56 @@ class Broker : private boost::noncopyable {
     int solutionBrokerFd = -1;
     int brokerSolutionFd = -1;
 
+    /// Solution responds first.
     bool emptyFirstRequest = false;
+
+    /*!
+     * Every request starts with encoded CommandPack,
+     * RESPONSE_MULTIPLIER command overrides responseMultiplier.
+     * Command pack is not forwarded to solution.
+     */
+    bool requestCommands = false;
+
+    /*!
+     * Interactor may start the first request with
+     * BINARY_COMMAND_PACK_MAGIC to switch the session to binary framing:
+     * every request is a binary CommandPack followed by varint
+     * payload length and raw payload, which is forwarded to solution
+     * as is and may contain request delimiter.
+     * Otherwise requests are delimiter-terminated as usual.
+     */
+    bool binaryCommands = false;
+
+    /*!
+     * Size limit of binary command pack with payload length,
+     * larger request is INTERACTOR_INVALID_COMMAND.
+     */
+    std::size_t maxHeaderSize = 64 * 1024;
+
+    /// Number of responses per request.
+    std::size_t responseMultiplier = 1;
   };
 
-  BUNSAN_INCLASS_STREAM_ENUM(Status, (OK))
+  BUNSAN_INCLASS_STREAM_ENUM(Status, (
+    OK,
+
+    /// I/O failure.
+    FAILED,
+
+    /// Interactor has closed its output inside a request.
+    INTERACTOR_INSUFFICIENT_DATA,
+
+    /// Request command pack can't be decoded.
+    INTERACTOR_INVALID_COMMAND,
+
+    /// Solution has closed its output before response was complete.
+    SOLUTION_INSUFFICIENT_DATA,
+
+    /// Solution has written data after the last request.
+    SOLUTION_EXCESS_DATA
+  ))
 
+  /// \throws BrokerEmptyDelimiterError
   explicit Broker(const Options &options);
 
   Status run();
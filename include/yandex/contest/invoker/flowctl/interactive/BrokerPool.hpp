@@ -0,0 +1,123 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/SimpleBroker.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+class SimpleBrokerSession;
+
+/*!
+ * \brief Runs many SimpleBroker sessions on a fixed set of threads.
+ *
+ * Each worker runs its own io_service in a single thread,
+ * so handlers of a session are serialized without strands
+ * and sessions of different workers never contend.
+ * Started session stays on its worker, sessions which are
+ * not started yet are stolen by workers with spare capacity.
+ *
+ * Exception escaping a session handler fails the session
+ * and the worker keeps running. Asio can't tell which session
+ * the handler belonged to, so if the worker runs several sessions
+ * all of them are failed.
+ */
+class BrokerPool : private boost::noncopyable {
+ public:
+  struct Options {
+    /// 0 means number of hardware threads.
+    std::size_t workers = 0;
+
+    /// Maximum number of sessions running on a worker simultaneously.
+    std::size_t sessionsPerWorker = 64;
+  };
+
+  using Status = SimpleBroker::Status;
+
+  /// Exception is set if session has failed to start or has thrown.
+  using Handler = std::function<void(std::exception_ptr, Status)>;
+
+ public:
+  BrokerPool();
+  explicit BrokerPool(const Options &options);
+
+  /// Waits for submitted sessions.
+  ~BrokerPool();
+
+  /// Handler is called from worker thread.
+  void submit(const SimpleBroker::Options &options, const Handler &handler);
+
+  std::future<Status> submit(const SimpleBroker::Options &options);
+
+  /// Wait until all submitted sessions have completed.
+  void wait();
+
+ private:
+  struct Session {
+    SimpleBroker::Options options;
+    Handler handler;
+  };
+
+  struct Worker {
+    boost::asio::io_service ioService;
+    std::unique_ptr<boost::asio::io_service::work> work;
+    std::thread thread;
+
+    std::mutex lock;
+    std::deque<Session> pending;
+
+    /// Sessions started by this worker.
+    std::atomic<std::size_t> active{0};
+
+    /// Running sessions, used from worker thread only.
+    std::vector<std::weak_ptr<SimpleBrokerSession>> sessions;
+  };
+
+  /// Worker thread body, restarts io_service after exceptions.
+  void run(Worker &worker);
+
+  /// Fail sessions after an exception has escaped io_service.
+  void fail(Worker &worker, std::exception_ptr error);
+
+  /// Start pending sessions, called from worker thread.
+  void schedule(Worker &worker);
+
+  bool pop(Worker &worker, Session &session);
+  bool steal(Worker &thief, Session &session);
+  void start(Worker &worker, Session &session);
+  static void forget(Worker &worker,
+                     const std::weak_ptr<SimpleBrokerSession> &session);
+  void complete(Worker &worker, const Handler &handler,
+                std::exception_ptr error, Status status);
+
+ private:
+  const std::size_t sessionsPerWorker_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<std::size_t> next_{0};
+
+  std::mutex lock_;
+  std::condition_variable completed_;
+  std::size_t sessions_ = 0;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
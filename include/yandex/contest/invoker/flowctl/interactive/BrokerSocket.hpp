@@ -0,0 +1,62 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/SimpleBroker.hpp>
+
+#include <yandex/contest/system/unistd/Descriptor.hpp>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+
+#include <sys/types.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*
+ * SimpleBroker sessions are handed off to a daemon over Unix domain socket.
+ *
+ * Request is a single message: session file descriptors are passed
+ * via SCM_RIGHTS, the rest of options is encoded in payload.
+ * Dump and statistics files are opened by client and passed
+ * the same way, daemon never opens paths it has received.
+ * Reply is SimpleBroker::Status.
+ */
+
+/// Clients allowed to connect besides root and daemon's own user.
+struct BrokerSocketAccess {
+  /// Members of this group, socket file is owned by it.
+  boost::optional<gid_t> group;
+};
+
+system::unistd::Descriptor connectBrokerSocket(
+    const boost::filesystem::path &path);
+
+/*!
+ * \brief Existing socket file is replaced.
+ *
+ * Socket file mode is 0600, or 0660 if access has a group.
+ */
+system::unistd::Descriptor listenBrokerSocket(
+    const boost::filesystem::path &path,
+    const BrokerSocketAccess &access = BrokerSocketAccess());
+
+/// Throws BrokerSocketAccessError unless peer is permitted by access.
+void checkBrokerPeer(int socket, const BrokerSocketAccess &access);
+
+/// Output files without file descriptors are opened by this call.
+void sendBrokerSession(int socket, const SimpleBroker::Options &options);
+
+/// Received file descriptors including output files are owned by caller.
+SimpleBroker::Options receiveBrokerSession(int socket);
+
+void sendBrokerStatus(int socket, SimpleBroker::Status status);
+SimpleBroker::Status receiveBrokerStatus(int socket);
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
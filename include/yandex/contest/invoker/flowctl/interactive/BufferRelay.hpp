@@ -0,0 +1,139 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/Relay.hpp>
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/optional.hpp>
+
+#include <array>
+#include <chrono>
+#include <vector>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Userspace relay, every chunk is read into a buffer and written back.
+ *
+ * Two buffers are used, so the next chunk is read
+ * while the previous one is being written.
+ */
+class BufferRelay : public Relay {
+ public:
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+  /*!
+   * \brief Batch small reads into a single write.
+   *
+   * Pending data is written when any condition is met:
+   * threshold bytes are pending, delimiter was read,
+   * the oldest pending byte has waited for delay,
+   * buffer is full or source is done.
+   * Delay bounds the time data is held back,
+   * so peer never waits for it indefinitely.
+   */
+  struct CoalescingOptions {
+    /// 0 means buffer size.
+    std::size_t threshold = 0;
+    boost::optional<char> delimiter;
+
+    /// Coalescing is disabled unless positive.
+    std::chrono::microseconds delay{0};
+  };
+
+ public:
+  BufferRelay(Connection &source, Connection &sink,
+              const Handler &readHandler, const Handler &writeHandler,
+              std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /*!
+   * \brief Grow buffers while reads keep filling them.
+   *
+   * Buffer size is doubled after every read that has filled it
+   * until maxBufferSize is reached.
+   */
+  void setMaxBufferSize(std::size_t maxBufferSize);
+
+  void setCoalescing(const CoalescingOptions &options);
+
+  /// Current size of a single buffer.
+  std::size_t bufferSize() const { return bufferSize_; }
+
+  void setCloseSinkOnEof(bool closeSinkOnEof) override;
+  void setDiscardOnSinkError(bool discardOnSinkError) override;
+
+  void setReadDataHandler(const DataHandler &handler) {
+    readDataHandler_ = handler;
+  }
+
+  void setWriteDataHandler(const DataHandler &handler) {
+    writeDataHandler_ = handler;
+  }
+
+  void start() override;
+  void close() override;
+  void terminate() override;
+
+ private:
+  struct Chunk {
+    std::vector<char> data;
+    std::size_t size = 0;
+  };
+
+  /// Chunk being read into.
+  Chunk &openChunk() { return chunks_[(written_ + filled_) % chunks_.size()]; }
+
+  void read();
+  void handle_read(const boost::system::error_code &ec, std::size_t size);
+
+  bool coalesced(const Chunk &chunk, std::size_t size) const;
+  void flush();
+  void handle_deadline(const boost::system::error_code &ec);
+
+  void write();
+  void handle_write(const boost::system::error_code &ec, std::size_t size);
+
+  void finish();
+
+ private:
+  Connection &source_;
+  Connection &sink_;
+  const Handler readHandler_;
+  const Handler writeHandler_;
+  DataHandler readDataHandler_;
+  DataHandler writeDataHandler_;
+
+  std::size_t bufferSize_;
+  std::size_t maxBufferSize_;
+
+  bool closeSinkOnEof_ = true;
+  bool discardOnSinkError_ = false;
+
+  boost::optional<CoalescingOptions> coalescing_;
+  boost::asio::steady_timer deadline_;
+  bool deadlineArmed_ = false;
+
+  /// Read was canceled to flush on deadline.
+  bool flushRequested_ = false;
+
+  /// chunks_[written_] is written first, filled_ chunks are pending.
+  std::array<Chunk, 2> chunks_;
+  std::size_t written_ = 0;
+  std::size_t filled_ = 0;
+
+  bool reading_ = false;
+  bool writing_ = false;
+  bool sourceDone_ = false;
+  bool sinkFailed_ = false;
+  bool closing_ = false;
+  bool finished_ = false;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -1,17 +1,19 @@
 #pragma once
 
-#include <boost/version.hpp>
-#if BOOST_VERSION < 106100
-#define BOOST_NO_CXX11_VARIADIC_TEMPLATES
-#endif
+#include <yandex/contest/invoker/flowctl/interactive/AsyncDump.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/BufferRelay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/Event.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/Relay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/RelayStatistics.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/SpliceDump.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/UringRelay.hpp>
 
-#include <bunsan/asio/buffer_connection.hpp>
-#include <bunsan/filesystem/fstream.hpp>
+#include <yandex/contest/system/unistd/Descriptor.hpp>
 
 #include <boost/asio.hpp>
 #include <boost/asio/posix/stream_descriptor.hpp>
-#include <boost/signals2.hpp>
 
+#include <exception>
 #include <memory>
 
 namespace yandex {
@@ -22,23 +24,69 @@ namespace interactive {
 
 class BufferedConnection : private boost::noncopyable {
  public:
-  using Connection = boost::asio::posix::stream_descriptor;
-  using Buffer = bunsan::asio::buffer_connection<Connection, Connection>;
-  using StaticEventSignal = boost::signals2::signal<void()>;
-  using ErrorSignal =
-      boost::signals2::signal<void(boost::system::error_code, std::size_t)>;
+  using Connection = Relay::Connection;
+  using StaticEventSignal = Event<void()>;
+  using ErrorSignal = Event<void(boost::system::error_code, std::size_t)>;
+  using ExceptionSignal = Event<void(std::exception_ptr)>;
 
  public:
   BufferedConnection(Connection &interactorSource, Connection &interactorSink,
                      Connection &solutionSource, Connection &solutionSink,
                      const std::size_t outputLimitBytes);
 
+  void setRelayMode(const Relay::Mode relayMode) { relayMode_ = relayMode; }
+
+  /// Userspace relay buffer size, 0 keeps relay's default.
+  void setRelayBufferSize(const std::size_t size) { relayBufferSize_ = size; }
+
+  /// Grow buffered relay's buffers up to size while reads fill them.
+  void setMaxRelayBufferSize(const std::size_t size) {
+    maxRelayBufferSize_ = size;
+  }
+
+  /// Capacity of all connections and splice pipes, 0 keeps kernel default.
+  void setPipeCapacity(const std::size_t capacity) {
+    pipeCapacity_ = capacity;
+  }
+
+  /// Coalesce interactor's output in buffered relay mode.
+  void setInteractorCoalescing(const BufferRelay::CoalescingOptions &options) {
+    interactorCoalescing_ = options;
+  }
+
+  /// Coalesce solution's output in buffered relay mode.
+  void setSolutionCoalescing(const BufferRelay::CoalescingOptions &options) {
+    solutionCoalescing_ = options;
+  }
+
   void setDumpJudge(const boost::filesystem::path &path) { dumpJudge_ = path; }
 
+  /// Dump into file opened by caller, path is used in messages only.
+  void setDumpJudge(const boost::filesystem::path &path,
+                    system::unistd::Descriptor file) {
+    dumpJudge_ = path;
+    dumpJudgeFile_ = std::move(file);
+  }
+
   void setDumpSolution(const boost::filesystem::path &path) {
     dumpSolution_ = path;
   }
 
+  /// Dump into file opened by caller, path is used in messages only.
+  void setDumpSolution(const boost::filesystem::path &path,
+                       system::unistd::Descriptor file) {
+    dumpSolution_ = path;
+    dumpSolutionFile_ = std::move(file);
+  }
+
+  /// Write buffered relay dumps from a separate thread.
+  void setAsyncDump(const AsyncDump::Options &options) {
+    asyncDump_ = options;
+  }
+
+  /// Collect per-direction relay statistics, must be called before start().
+  void enableStatistics();
+
   void start();
 
   void closeInteractorToSolution();
@@ -49,6 +97,20 @@ class BufferedConnection : private boost::noncopyable {
   void terminateSolutionToInteractor();
   void terminate();
 
+  /// Wait for asynchronous dumps to be written.
+  void flushDumps();
+
+  /// Available after flushDumps() if asynchronous dump was used.
+  boost::optional<AsyncDump::Statistics> judgeDumpStatistics() const;
+  boost::optional<AsyncDump::Statistics> solutionDumpStatistics() const;
+
+  /// Available if statistics are enabled.
+  boost::optional<RelayStatistics> interactorToSolutionStatistics() const;
+  boost::optional<RelayStatistics> solutionToInteractorStatistics() const;
+
+  /// Always collected.
+  const ThinkTime &thinkTime() const { return thinkTimeMonitor_.thinkTime(); }
+
   StaticEventSignal interactorEof;
   StaticEventSignal solutionEof;
 
@@ -60,7 +122,27 @@ class BufferedConnection : private boost::noncopyable {
   ErrorSignal solutionReadError;
   ErrorSignal solutionWriteError;
 
+  /*!
+   * \brief Dump can't be written, dump is abandoned.
+   *
+   * Raised from io_service even if relay calls
+   * data handlers from its own threads.
+   */
+  ExceptionSignal dumpError;
+
  private:
+  Relay::DataHandler openJudgeDump();
+  Relay::DataHandler openSolutionDump();
+
+  bool useSplice(Connection &source, Connection &sink, bool writeDump);
+
+  void applyPipeCapacity(const char *name, Connection &connection);
+
+  std::unique_ptr<BufferRelay> makeBufferRelay(
+      Connection &source, Connection &sink, const Relay::Handler &readHandler,
+      const Relay::Handler &writeHandler,
+      const boost::optional<BufferRelay::CoalescingOptions> &coalescing);
+
   void handle_interactor_read(const boost::system::error_code &ec,
                               std::size_t size);
 
@@ -77,18 +159,45 @@ class BufferedConnection : private boost::noncopyable {
   void handle_solution_write(const boost::system::error_code &ec,
                              std::size_t size);
 
+  /// Report current exception through dumpError.
+  void dumpFailed(const char *name);
+
  private:
-  Buffer interactorToSolutionBuffer_;
-  Buffer solutionToInteractorBuffer_;
+  Connection &interactorSource_;
+  Connection &interactorSink_;
+  Connection &solutionSource_;
+  Connection &solutionSink_;
+
+  Relay::Mode relayMode_ = Relay::Mode::BUFFERED;
+  std::size_t relayBufferSize_ = 0;
+  std::size_t maxRelayBufferSize_ = 0;
+  std::size_t pipeCapacity_ = 0;
+  boost::optional<BufferRelay::CoalescingOptions> interactorCoalescing_;
+  boost::optional<BufferRelay::CoalescingOptions> solutionCoalescing_;
+  std::unique_ptr<UringLoop> uringLoop_;
+  std::unique_ptr<SpliceDump> judgeSpliceDump_;
+  std::unique_ptr<SpliceDump> solutionSpliceDump_;
+  std::unique_ptr<Relay> interactorToSolution_;
+  std::unique_ptr<Relay> solutionToInteractor_;
 
   const std::size_t outputLimitBytes_;
   std::size_t interactorOutputBytes_ = 0;
   std::size_t solutionOutputBytes_ = 0;
 
+  std::unique_ptr<RelayMonitor> interactorToSolutionMonitor_;
+  std::unique_ptr<RelayMonitor> solutionToInteractorMonitor_;
+  ThinkTimeMonitor thinkTimeMonitor_;
+
   boost::optional<boost::filesystem::path> dumpJudge_;
   boost::optional<boost::filesystem::path> dumpSolution_;
-  std::unique_ptr<bunsan::filesystem::ofstream> dumpJudgeStream_;
-  std::unique_ptr<bunsan::filesystem::ofstream> dumpSolutionStream_;
+
+  /// Opened by caller or on start, written directly if not moved to dump.
+  system::unistd::Descriptor dumpJudgeFile_;
+  system::unistd::Descriptor dumpSolutionFile_;
+
+  boost::optional<AsyncDump::Options> asyncDump_;
+  std::unique_ptr<AsyncDump> judgeAsyncDump_;
+  std::unique_ptr<AsyncDump> solutionAsyncDump_;
 };
 
 }  // namespace interactive
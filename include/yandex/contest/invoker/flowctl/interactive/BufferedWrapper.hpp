@@ -1,6 +1,6 @@
 #pragma once
 
-#include <yandex/contest/system/unistd/Pipe.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/InProcessPipe.hpp>
 
 #include <bunsan/asio/buffer_connection.hpp>
 
@@ -13,11 +13,22 @@ namespace invoker {
 namespace flowctl {
 namespace interactive {
 
+/*!
+ * \brief Exposes buffered Source and Sink of underlying streams.
+ *
+ * Source and Sink are connected to buffers by InProcessPipe,
+ * so data is passed without extra system calls and file descriptors.
+ *
+ * \note Source and Sink used to be stream_descriptor,
+ * now they only support asynchronous operations with copyable handlers,
+ * close(), cancel() and is_open(), see InProcessPipe.
+ * Code which needs a file descriptor should use underlying streams.
+ */
 class BufferedWrapper : private boost::noncopyable {
  public:
-  using Source = boost::asio::posix::stream_descriptor;
+  using Source = InProcessPipe::ReadEnd;
   using UnderlyingSource = boost::asio::posix::stream_descriptor;
-  using Sink = boost::asio::posix::stream_descriptor;
+  using Sink = InProcessPipe::WriteEnd;
   using UnderlyingSink = boost::asio::posix::stream_descriptor;
   using SourceBuffer = bunsan::asio::buffer_connection<UnderlyingSource, Sink>;
   using SinkBuffer = bunsan::asio::buffer_connection<Source, UnderlyingSink>;
@@ -35,13 +46,11 @@ class BufferedWrapper : private boost::noncopyable {
                   const Handler &sinkWriteHandler)
       : underlyingSource_(underlyingSource),
         underlyingSink_(underlyingSink),
-        sourceInput_(ioService, sourcePipe_.releaseWriteEnd().release()),
-        sinkOutput_(ioService, sinkPipe_.releaseReadEnd().release()),
-        source_(ioService, sourcePipe_.releaseReadEnd().release()),
-        sink_(ioService, sinkPipe_.releaseWriteEnd().release()),
-        sourceBuffer_(underlyingSource_, sourceInput_, sourceReadHandler,
-                      sourceWriteHandler),
-        sinkBuffer_(sinkOutput_, underlyingSink_, sinkReadHandler,
+        sourcePipe_(ioService),
+        sinkPipe_(ioService),
+        sourceBuffer_(underlyingSource_, sourcePipe_.writeEnd(),
+                      sourceReadHandler, sourceWriteHandler),
+        sinkBuffer_(sinkPipe_.readEnd(), underlyingSink_, sinkReadHandler,
                     sinkWriteHandler) {}
 
   BufferedWrapper(UnderlyingSource &underlyingSource,
@@ -59,8 +68,8 @@ class BufferedWrapper : private boost::noncopyable {
     sinkBuffer_.start();
   }
 
-  Source &source() { return source_; }
-  Sink &sink() { return sink_; }
+  Source &source() { return sourcePipe_.readEnd(); }
+  Sink &sink() { return sinkPipe_.writeEnd(); }
 
   void close() {
     sourceBuffer_.close();
@@ -76,14 +85,8 @@ class BufferedWrapper : private boost::noncopyable {
   UnderlyingSource &underlyingSource_;
   UnderlyingSink &underlyingSink_;
 
-  yandex::contest::system::unistd::Pipe sourcePipe_;
-  yandex::contest::system::unistd::Pipe sinkPipe_;
-
-  Sink sourceInput_;
-  Source sinkOutput_;
-
-  Source source_;
-  Sink sink_;
+  InProcessPipe sourcePipe_;
+  InProcessPipe sinkPipe_;
 
   SourceBuffer sourceBuffer_;
   SinkBuffer sinkBuffer_;
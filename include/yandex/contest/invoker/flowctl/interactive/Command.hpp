@@ -28,24 +28,28 @@ enum CommandClass : UnderlyingType {
   PARAMETER_CLASS = VERDICT_CLASS | RESPONSE_INFO_CLASS,
 };
 
+/// List of (name, value), also used to generate name tables.
+#define YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_NAMES             \
+  ((REQUEST, REQUEST_CLASS | 0x01), (EMPTY_REQUEST, REQUEST_CLASS | 0x02),   \
+   (LAST_REQUEST, REQUEST_CLASS | 0x04),                                     \
+   (EOF_REQUEST, EMPTY_REQUEST | LAST_REQUEST),                              \
+                                                                             \
+   (RESPONSE, RESPONSE_CLASS | 0x01), (LAST_RESPONSE, RESPONSE_CLASS | 0x02), \
+   (EMPTY_RESPONSE, RESPONSE_CLASS | 0x04),                                  \
+   (EOF_RESPONSE, EMPTY_RESPONSE | LAST_RESPONSE),                           \
+                                                                             \
+   (CLOSE, EOF_REQUEST | EOF_RESPONSE),                                      \
+                                                                             \
+   (OK_VERDICT, VERDICT_CLASS | 0x01),                                       \
+   (OK_VERDICT_CUSTOM, VERDICT_CLASS | 0x02),                                \
+   (ERROR_VERDICT, VERDICT_CLASS | 0x04),                                    \
+   (ERROR_VERDICT_CUSTOM, VERDICT_CLASS | 0x08),                             \
+                                                                             \
+   (RESPONSE_MULTIPLIER, RESPONSE_INFO_CLASS | 0x01))
+
 BUNSAN_TYPED_STREAM_ENUM_INITIALIZED(
     CommandName, UnderlyingType,
-    ((REQUEST, REQUEST_CLASS | 0x01), (EMPTY_REQUEST, REQUEST_CLASS | 0x02),
-     (LAST_REQUEST, REQUEST_CLASS | 0x04),
-     (EOF_REQUEST, EMPTY_REQUEST | LAST_REQUEST),
-
-     (RESPONSE, RESPONSE_CLASS | 0x01), (LAST_RESPONSE, RESPONSE_CLASS | 0x02),
-     (EMPTY_RESPONSE, RESPONSE_CLASS | 0x04),
-     (EOF_RESPONSE, EMPTY_RESPONSE | LAST_RESPONSE),
-
-     (CLOSE, EOF_REQUEST | EOF_RESPONSE),
-
-     (OK_VERDICT, VERDICT_CLASS | 0x01),
-     (OK_VERDICT_CUSTOM, VERDICT_CLASS | 0x02),
-     (ERROR_VERDICT, VERDICT_CLASS | 0x04),
-     (ERROR_VERDICT_CUSTOM, VERDICT_CLASS | 0x08),
-
-     (RESPONSE_MULTIPLIER, RESPONSE_INFO_CLASS | 0x01)))
+    YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_NAMES)
 
 using CommandPack = std::map<CommandName, std::string>;
 using Command = std::pair<CommandName, std::string>;
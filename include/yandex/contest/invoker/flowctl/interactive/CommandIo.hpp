@@ -1,6 +1,14 @@
 #pragma once
 
 #include <yandex/contest/invoker/flowctl/interactive/Command.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/CommandSet.hpp>
+
+#include <boost/system/error_code.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <ostream>
+#include <string>
+#include <type_traits>
 
 namespace yandex {
 namespace contest {
@@ -19,8 +27,90 @@ Command decodeCommand(const std::string &data);
 std::string encodeCommandPack(const CommandPack &pack);
 CommandPack decodeCommandPack(const std::string &data);
 
+std::string encodeCommandPack(const CommandSet &set);
+/// Set is replaced.
+void decodeCommandPack(const std::string &data, CommandSet &set);
+
+/*
+ * Allocation-free interface.
+ *
+ * Encoders write into caller's buffer which must have room
+ * for maxEncoded*Size() bytes and return number of bytes written.
+ * append* functions append to a string reusing its capacity.
+ * Decoders report errors through error code and return number of
+ * consumed bytes, which is the position of invalid character on error.
+ *
+ * Every decoder accepts the same commands: only parameters may have
+ * a value, flag with non-empty value is CommandIoErrc::UNEXPECTED_VALUE,
+ * "NAME=" is the same as "NAME".
+ */
+
+using StringRef = boost::string_ref;
+
+enum class CommandIoErrc {
+  CHARACTER_IS_NOT_PERMITTED = 1,
+  DIGIT_EXPECTED,
+  INVALID_ESCAPE_SEQUENCE,
+  UNKNOWN_COMMAND_NAME,
+  UNEXPECTED_VALUE,
+  INSUFFICIENT_DATA,
+  INVALID_LENGTH,
+};
+
+const boost::system::error_category &commandIoCategory();
+
+boost::system::error_code make_error_code(CommandIoErrc errc);
+
+/// \return false if name is unknown
+bool parseCommandName(StringRef data, CommandName &name);
+
+StringRef commandNameString(CommandName name);
+
+constexpr std::size_t maxEncodedCommandValueSize(const std::size_t size) {
+  return 3 * size;
+}
+
+std::size_t maxEncodedCommandSize(const Command &command);
+std::size_t maxEncodedCommandPackSize(const CommandPack &pack);
+std::size_t maxEncodedCommandPackSize(const CommandSet &set);
+
+std::size_t encodeCommandValueTo(StringRef value, char *out);
+std::size_t encodeCommandTo(const Command &command, char *out);
+std::size_t encodeCommandPackTo(const CommandPack &pack, char *out);
+std::size_t encodeCommandPackTo(const CommandSet &set, char *out);
+
+void appendEncodedCommandValue(StringRef value, std::string &out);
+void appendEncodedCommand(const Command &command, std::string &out);
+void appendEncodedCommandPack(const CommandPack &pack, std::string &out);
+void appendEncodedCommandPack(const CommandSet &set, std::string &out);
+
+/// Value is replaced.
+std::size_t decodeCommandValueTo(StringRef data, std::string &value,
+                                 boost::system::error_code &ec);
+
+/// Command is replaced, its value capacity is reused.
+std::size_t decodeCommandTo(StringRef data, Command &command,
+                            boost::system::error_code &ec);
+
+/// Pack is replaced.
+std::size_t decodeCommandPackTo(StringRef data, CommandPack &pack,
+                                boost::system::error_code &ec);
+
+/// Set is replaced, capacity of its values is reused.
+std::size_t decodeCommandPackTo(StringRef data, CommandSet &set,
+                                boost::system::error_code &ec);
+
 }  // namespace interactive
 }  // namespace flowctl
 }  // namespace invoker
 }  // namespace contest
 }  // namespace yandex
+
+namespace boost {
+namespace system {
+template <>
+struct is_error_code_enum<
+    yandex::contest::invoker::flowctl::interactive::CommandIoErrc>
+    : std::true_type {};
+}  // namespace system
+}  // namespace boost
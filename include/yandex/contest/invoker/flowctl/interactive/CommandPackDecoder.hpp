@@ -0,0 +1,73 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/Command.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <functional>
+#include <string>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Push-style CommandPack decoder.
+ *
+ * Accepts pack in arbitrary chunks and emits every command
+ * as soon as its terminator is seen.
+ * Value buffer is reused between commands,
+ * so steady-state decoding does not allocate.
+ *
+ * Value escapes are hexadecimal, as produced by encodeCommandValue().
+ */
+class CommandPackDecoder : private boost::noncopyable {
+ public:
+  /// Value is valid only during the call.
+  using Handler = std::function<void(CommandName, const std::string &value)>;
+
+  static constexpr std::size_t MAX_NAME_SIZE = 64;
+
+ public:
+  explicit CommandPackDecoder(const Handler &handler);
+
+  /*!
+   * \brief Decode next chunk.
+   *
+   * Stops right after pack terminator.
+   *
+   * \return number of consumed bytes
+   *
+   * \throws CommandIoError, decoder has to be reset
+   */
+  std::size_t feed(const char *data, std::size_t size);
+
+  /// Pack terminator has been consumed.
+  bool complete() const { return state_ == State::COMPLETE; }
+
+  /// Start decoding next pack.
+  void reset();
+
+ private:
+  enum class State { NAME, VALUE, ESCAPE_HIGH, ESCAPE_LOW, COMPLETE };
+
+  void emit();
+  CommandName name() const;
+
+ private:
+  const Handler handler_;
+
+  State state_ = State::NAME;
+  char name_[MAX_NAME_SIZE];
+  std::size_t nameSize_ = 0;
+  std::string value_;
+  unsigned escape_ = 0;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/Command.hpp>
+
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/seq/for_each_i.hpp>
+#include <boost/preprocessor/tuple/elem.hpp>
+#include <boost/preprocessor/tuple/to_seq.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <array>
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace detail {
+#define YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_SET_NAME(R, DATA, \
+                                                                    ELEM)    \
+  BOOST_PP_TUPLE_ELEM(2, 0, ELEM),
+
+/// Command names in declaration order, which is ascending.
+constexpr CommandName COMMAND_SET_NAMES[] = {BOOST_PP_SEQ_FOR_EACH(
+    YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_SET_NAME, ~,
+    BOOST_PP_TUPLE_TO_SEQ(
+        YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_NAMES))};
+
+#undef YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_SET_NAME
+
+constexpr std::size_t COMMAND_SET_NAMES_SIZE =
+    sizeof(COMMAND_SET_NAMES) / sizeof(COMMAND_SET_NAMES[0]);
+
+/// Number of parameters among first size names.
+constexpr std::size_t commandSetParameters(const std::size_t size) {
+  return size == 0 ? 0 : commandSetParameters(size - 1) +
+                             isParameter(COMMAND_SET_NAMES[size - 1]);
+}
+
+/// Mask of parameters among first size names.
+constexpr std::uint32_t commandSetParameterMask(const std::size_t size) {
+  return size == 0
+             ? 0
+             : commandSetParameterMask(size - 1) |
+                   (isParameter(COMMAND_SET_NAMES[size - 1])
+                        ? std::uint32_t(1) << (size - 1)
+                        : 0);
+}
+}  // namespace detail
+
+/*!
+ * \brief Compact set of commands.
+ *
+ * Presence of every command is a bit in a mask indexed by
+ * position of command in CommandName declaration,
+ * values of parameter commands are stored inline.
+ * Flags have no value.
+ *
+ * Iteration is in ascending CommandName order, same as CommandPack.
+ */
+class CommandSet {
+ public:
+  using Mask = std::uint32_t;
+
+  static constexpr std::size_t CAPACITY = detail::COMMAND_SET_NAMES_SIZE;
+  static constexpr std::size_t PARAMETERS =
+      detail::commandSetParameters(CAPACITY);
+
+  static constexpr Mask PARAMETER_MASK =
+      detail::commandSetParameterMask(CAPACITY);
+
+  static_assert(CAPACITY <= sizeof(Mask) * 8, "Mask is too small");
+
+  class const_iterator
+      : public boost::iterator_facade<const_iterator, const CommandName,
+                                      boost::forward_traversal_tag,
+                                      CommandName> {
+   public:
+    const_iterator() = default;
+    explicit const_iterator(const Mask mask) : mask_(mask) {}
+
+   private:
+    friend class boost::iterator_core_access;
+
+    CommandName dereference() const {
+      return detail::COMMAND_SET_NAMES[__builtin_ctz(mask_)];
+    }
+
+    void increment() { mask_ &= mask_ - 1; }
+
+    bool equal(const const_iterator &other) const {
+      return mask_ == other.mask_;
+    }
+
+    Mask mask_ = 0;
+  };
+
+  using iterator = const_iterator;
+
+ public:
+  CommandSet() = default;
+
+  /// Values of flags are dropped.
+  explicit CommandSet(const CommandPack &pack);
+
+  CommandPack toCommandPack() const;
+
+  bool empty() const { return mask_ == 0; }
+  std::size_t size() const { return __builtin_popcount(mask_); }
+  Mask mask() const { return mask_; }
+
+  const_iterator begin() const { return const_iterator(mask_); }
+  const_iterator end() const { return const_iterator(); }
+
+  bool contains(const CommandName name) const {
+    return mask_ & bit(name);
+  }
+
+  /// Empty for flags and absent parameters.
+  const std::string &value(CommandName name) const;
+
+  /*!
+   * \brief Value of parameter, inserted if absent.
+   *
+   * \pre isParameter(name)
+   */
+  std::string &parameter(CommandName name);
+
+  /// Parameters are inserted with empty value.
+  void insert(CommandName name);
+
+  /// \pre isParameter(name) || value.empty()
+  void insert(CommandName name, boost::string_ref value);
+
+  void erase(const CommandName name) { mask_ &= ~bit(name); }
+
+  /// Capacity of parameter values is kept.
+  void clear() { mask_ = 0; }
+
+  /// Position in CommandName declaration.
+  static std::size_t index(CommandName name);
+
+  /// \pre index < CAPACITY
+  static CommandName name(const std::size_t index) {
+    return detail::COMMAND_SET_NAMES[index];
+  }
+
+  friend bool operator==(const CommandSet &a, const CommandSet &b);
+
+  friend bool operator!=(const CommandSet &a, const CommandSet &b) {
+    return !(a == b);
+  }
+
+ private:
+  static Mask bit(const CommandName name) { return Mask(1) << index(name); }
+
+  static std::size_t parameterIndex(CommandName name);
+
+ private:
+  Mask mask_ = 0;
+  std::array<std::string, PARAMETERS> parameters_;
+};
+
+#define YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_SET_INDEX(R, DATA, \
+                                                                     I, ELEM) \
+  case BOOST_PP_TUPLE_ELEM(2, 0, ELEM):                                       \
+    return I;
+
+inline std::size_t CommandSet::index(const CommandName name) {
+  switch (name) {
+    BOOST_PP_SEQ_FOR_EACH_I(
+        YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_SET_INDEX, ~,
+        BOOST_PP_TUPLE_TO_SEQ(
+            YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_NAMES))
+  }
+  return CAPACITY;
+}
+
+#undef YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_SET_INDEX
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
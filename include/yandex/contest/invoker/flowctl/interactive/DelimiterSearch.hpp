@@ -0,0 +1,63 @@
+#pragma once
+
+#include <bunsan/stream_enum.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Finds multi-byte delimiter in a buffer.
+ *
+ * Vectorized implementations compare first and last
+ * delimiter bytes against a whole block at once
+ * and verify the rest of delimiter for candidates only.
+ */
+class DelimiterSearch {
+ public:
+  BUNSAN_INCLASS_STREAM_ENUM_CLASS(Implementation, (
+    SCALAR,
+    SSE2,
+    AVX2
+  ))
+
+  static constexpr std::size_t npos = std::string::npos;
+
+  /// The best implementation supported by CPU.
+  static Implementation bestImplementation();
+
+  static bool isSupported(Implementation implementation);
+
+ public:
+  /// \pre !delimiter.empty()
+  explicit DelimiterSearch(const std::string &delimiter);
+
+  DelimiterSearch(const std::string &delimiter,
+                  Implementation implementation);
+
+  const std::string &delimiter() const { return delimiter_; }
+  Implementation implementation() const { return implementation_; }
+
+  /// \return offset of the first delimiter occurrence or npos
+  std::size_t find(const char *data, std::size_t size) const;
+
+ private:
+  using Function = std::size_t (*)(const char *data, std::size_t size,
+                                   const char *delimiter,
+                                   std::size_t delimiterSize);
+
+  std::string delimiter_;
+  Implementation implementation_;
+  Function find_;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
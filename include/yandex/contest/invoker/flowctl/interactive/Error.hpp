@@ -25,6 +25,15 @@ struct DecodeCommandError : virtual CommandIoError {};
 struct EncodeCommandPackError : virtual CommandIoError {};
 struct DecodeCommandPackError : virtual CommandIoError {};
 
+struct BrokerError : virtual Error {};
+struct BrokerEmptyDelimiterError : virtual BrokerError {};
+
+struct BrokerSocketError : virtual Error {};
+struct BrokerSocketProtocolError : virtual BrokerSocketError {};
+struct BrokerSocketAccessError : virtual BrokerSocketError {
+  using uid = boost::error_info<struct uidTag, unsigned>;
+};
+
 }  // namespace interactive
 }  // namespace flowctl
 }  // namespace invoker
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+template <typename Signature>
+class Event;
+
+/*!
+ * \brief Lightweight replacement of boost::signals2::signal.
+ *
+ * Slots are plain function objects called in connection order,
+ * emission takes no locks and does not allocate.
+ * Slots should be connected before events are raised
+ * and never from inside a slot.
+ *
+ * \note Unlike boost::signals2::signal::connect(), connect() returns void
+ * and slots can't be disconnected one by one.
+ * Code which kept the returned connection should use connectSlot()
+ * or connectExtendedSlot() from SignalAdapter.hpp,
+ * they return boost::signals2::connection.
+ *
+ * \see connectSignal() for signals2 listeners.
+ */
+template <typename... Args>
+class Event<void(Args...)> {
+ public:
+  using Slot = std::function<void(Args...)>;
+
+ public:
+  void connect(const Slot &slot) { slots_.push_back(slot); }
+
+  void disconnect_all_slots() { slots_.clear(); }
+
+  bool empty() const { return slots_.empty(); }
+
+  void operator()(Args... args) const {
+    for (const Slot &slot : slots_) slot(args...);
+  }
+
+ private:
+  std::vector<Slot> slots_;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/DelimiterSearch.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Reads delimiter-terminated frames from a stream.
+ *
+ * Data is read into a single growing buffer,
+ * already scanned bytes are never scanned again.
+ *
+ * Length-framed data can be read through the same buffer
+ * with async_peek() and async_read_chunk().
+ */
+class FrameReader : private boost::noncopyable {
+ public:
+  using Connection = boost::asio::posix::stream_descriptor;
+
+  /*!
+   * Frame includes delimiter and stays valid
+   * until the next async_read_frame() call.
+   *
+   * On error (including eof) unterminated rest of data is passed.
+   */
+  using Handler = std::function<void(const boost::system::error_code &,
+                                     const char *data, std::size_t size)>;
+
+ public:
+  FrameReader(Connection &source, const std::string &delimiter);
+
+  /// Handler is never called from inside this function.
+  void async_read_frame(const Handler &handler);
+
+  /// Read count consecutive frames as a single contiguous range.
+  void async_read_frames(std::size_t count, const Handler &handler);
+
+  /*!
+   * \brief Read at least one and at most maxSize bytes.
+   *
+   * \pre maxSize > 0
+   */
+  void async_read_chunk(std::size_t maxSize, const Handler &handler);
+
+  /*!
+   * \brief Wait until at least minSize bytes are buffered.
+   *
+   * All buffered data is passed to handler and is not consumed.
+   */
+  void async_peek(std::size_t minSize, const Handler &handler);
+
+ private:
+  enum class Mode { FRAMES, CHUNK, PEEK };
+
+  void start();
+  void consume();
+  bool scan();
+  bool scanFrames();
+  void call(const boost::system::error_code &ec);
+  void read();
+  void prepare();
+  void complete(const boost::system::error_code &ec, std::size_t size);
+
+ private:
+  Connection &source_;
+  const DelimiterSearch search_;
+  Handler handler_;
+
+  std::vector<char> buffer_;
+  std::size_t begin_ = 0;
+  std::size_t end_ = 0;
+
+  /// Offset from begin_ where delimiter search continues.
+  std::size_t scanned_ = 0;
+
+  /// Size of frames found so far, consumed on next read.
+  std::size_t frameSize_ = 0;
+
+  Mode mode_ = Mode::FRAMES;
+
+  /// Number of frames still to be found.
+  std::size_t remaining_ = 0;
+
+  /// Size limit of chunk or peek.
+  std::size_t limit_ = 0;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
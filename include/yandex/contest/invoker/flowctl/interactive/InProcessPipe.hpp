@@ -0,0 +1,154 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/asio/detail/buffer_sequence_adapter.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/version.hpp>
+
+#include <functional>
+#include <mutex>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief In-process replacement of a pipe between two asio streams.
+ *
+ * Ends provide the same asynchronous interface as
+ * boost::asio::posix::stream_descriptor.
+ * There is no intermediate buffer: pending write is completed
+ * by copying writer's buffer directly into pending reader's buffer,
+ * so no system calls and no file descriptors are involved.
+ *
+ * Like stream_descriptor, every end supports
+ * a single outstanding operation.
+ * Only the first buffer of a buffer sequence is used.
+ *
+ * \warning Ends are not a drop-in stream_descriptor:
+ * handlers are stored in std::function and must be copyable,
+ * synchronous read_some() and write_some(), native_handle()
+ * and non_blocking() are not provided.
+ */
+class InProcessPipe : private boost::noncopyable {
+ public:
+  using Handler =
+      std::function<void(const boost::system::error_code &, std::size_t)>;
+
+  class ReadEnd : private boost::noncopyable {
+   public:
+    explicit ReadEnd(InProcessPipe &pipe) : pipe_(pipe) {}
+
+    boost::asio::io_service &get_io_service() { return pipe_.ioService_; }
+
+#if BOOST_VERSION >= 106600
+    using executor_type = boost::asio::io_service::executor_type;
+    executor_type get_executor() { return pipe_.ioService_.get_executor(); }
+#endif
+
+    template <typename MutableBufferSequence, typename ReadHandler>
+    void async_read_some(const MutableBufferSequence &buffers,
+                         ReadHandler handler) {
+      pipe_.read(boost::asio::detail::buffer_sequence_adapter<
+                     boost::asio::mutable_buffer,
+                     MutableBufferSequence>::first(buffers),
+                 handler);
+    }
+
+    bool is_open() const;
+
+    void close();
+    void close(boost::system::error_code &ec);
+
+    void cancel();
+    void cancel(boost::system::error_code &ec);
+
+   private:
+    InProcessPipe &pipe_;
+  };
+
+  class WriteEnd : private boost::noncopyable {
+   public:
+    explicit WriteEnd(InProcessPipe &pipe) : pipe_(pipe) {}
+
+    boost::asio::io_service &get_io_service() { return pipe_.ioService_; }
+
+#if BOOST_VERSION >= 106600
+    using executor_type = boost::asio::io_service::executor_type;
+    executor_type get_executor() { return pipe_.ioService_.get_executor(); }
+#endif
+
+    template <typename ConstBufferSequence, typename WriteHandler>
+    void async_write_some(const ConstBufferSequence &buffers,
+                          WriteHandler handler) {
+      pipe_.write(boost::asio::detail::buffer_sequence_adapter<
+                      boost::asio::const_buffer,
+                      ConstBufferSequence>::first(buffers),
+                  handler);
+    }
+
+    bool is_open() const;
+
+    void close();
+    void close(boost::system::error_code &ec);
+
+    void cancel();
+    void cancel(boost::system::error_code &ec);
+
+   private:
+    InProcessPipe &pipe_;
+  };
+
+ public:
+  explicit InProcessPipe(boost::asio::io_service &ioService);
+
+  ReadEnd &readEnd() { return readEnd_; }
+  WriteEnd &writeEnd() { return writeEnd_; }
+
+ private:
+  template <typename Buffer>
+  struct Operation {
+    Buffer buffer;
+    Handler handler;
+  };
+
+  void read(const boost::asio::mutable_buffer &buffer,
+            const Handler &handler);
+  void write(const boost::asio::const_buffer &buffer, const Handler &handler);
+
+  void closeRead();
+  void closeWrite();
+
+  void cancelRead();
+  void cancelWrite();
+
+  /// Both operations are pending.
+  void transfer();
+
+  template <typename Buffer>
+  void complete(Operation<Buffer> &operation,
+                const boost::system::error_code &ec, std::size_t size);
+
+  void post(const Handler &handler, const boost::system::error_code &ec,
+            std::size_t size);
+
+ private:
+  boost::asio::io_service &ioService_;
+
+  mutable std::mutex lock_;
+  bool readOpen_ = true;
+  bool writeOpen_ = true;
+  Operation<boost::asio::mutable_buffer> read_;
+  Operation<boost::asio::const_buffer> write_;
+
+  ReadEnd readEnd_;
+  WriteEnd writeEnd_;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
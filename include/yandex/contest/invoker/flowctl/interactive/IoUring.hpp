@@ -0,0 +1,68 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/// Minimal io_uring(7) instance on top of raw system calls.
+class IoUring : private boost::noncopyable {
+ public:
+  explicit IoUring(unsigned entries);
+  ~IoUring();
+
+  /// Whether the kernel provides io_uring.
+  static bool isSupported();
+
+  /// \return zeroed submission entry or nullptr if queue is full
+  io_uring_sqe *getSqe();
+
+  /*!
+   * \brief Pass prepared entries to the kernel.
+   *
+   * \return number of submitted entries
+   */
+  unsigned submit();
+
+  /// \return false if completion queue is empty
+  bool popCompletion(io_uring_cqe &cqe);
+
+  void registerBuffers(const iovec *buffers, unsigned count);
+  void registerEventFd(int eventFd);
+
+ private:
+  int fd_;
+  io_uring_params params_;
+
+  void *sqRing_ = nullptr;
+  std::size_t sqRingSize_ = 0;
+  void *cqRing_ = nullptr;
+  std::size_t cqRingSize_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  std::size_t sqesSize_ = 0;
+
+  unsigned *sqHead_;
+  unsigned *sqTail_;
+  unsigned sqMask_;
+  unsigned *sqArray_;
+  unsigned *cqHead_;
+  unsigned *cqTail_;
+  unsigned cqMask_;
+  io_uring_cqe *cqes_;
+
+  /// Entries returned by getSqe() but not yet submitted.
+  unsigned sqeHead_ = 0;
+  unsigned sqeTail_ = 0;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
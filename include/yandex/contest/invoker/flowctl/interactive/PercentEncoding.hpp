@@ -0,0 +1,85 @@
+#pragma once
+
+#include <bunsan/stream_enum.hpp>
+
+#include <boost/system/error_code.hpp>
+
+#include <cstddef>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Percent-encoding kernels for command values.
+ *
+ * Bytes from [0-9A-Za-z_] are permitted and copied as is,
+ * other bytes are escaped as %XX.
+ * Vectorized implementations classify a whole block at once
+ * and copy runs of permitted bytes in bulk,
+ * escapes are expanded and collapsed through lookup tables.
+ */
+class PercentEncoding {
+ public:
+  BUNSAN_INCLASS_STREAM_ENUM_CLASS(Implementation, (
+    SCALAR,
+    SSE2,
+    AVX2
+  ))
+
+  /// The best implementation supported by CPU.
+  static Implementation bestImplementation();
+
+  static bool isSupported(Implementation implementation);
+
+  /// Implementation used by CommandIo.
+  static const PercentEncoding &instance();
+
+  /// Value of hexadecimal digit c or -1.
+  static int hexDigit(char c);
+
+ public:
+  PercentEncoding();
+  explicit PercentEncoding(Implementation implementation);
+
+  Implementation implementation() const { return implementation_; }
+
+  /// Length of the longest prefix of permitted bytes.
+  std::size_t permittedPrefix(const char *data, std::size_t size) const {
+    return permittedPrefix_(data, size);
+  }
+
+  /*!
+   * \brief Encode data into out.
+   *
+   * \pre out has room for 3 * size bytes
+   * \return number of bytes written
+   */
+  std::size_t encode(const char *data, std::size_t size, char *out) const;
+
+  /*!
+   * \brief Decode data into out.
+   *
+   * \pre out has room for size bytes
+   * \return number of consumed bytes, position of failure on error
+   *
+   * Errors are reported as CommandIoErrc.
+   */
+  std::size_t decode(const char *data, std::size_t size, char *out,
+                     std::size_t &outSize,
+                     boost::system::error_code &ec) const;
+
+ private:
+  using PermittedPrefix = std::size_t (*)(const char *data, std::size_t size);
+
+  Implementation implementation_;
+  PermittedPrefix permittedPrefix_;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <bunsan/stream_enum.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <functional>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/// One direction of data flow: source > sink.
+class Relay : private boost::noncopyable {
+ public:
+  using Connection = boost::asio::posix::stream_descriptor;
+  using Handler =
+      std::function<void(const boost::system::error_code &, std::size_t)>;
+  using DataHandler = std::function<void(const char *, std::size_t)>;
+
+  BUNSAN_INCLASS_STREAM_ENUM_CLASS(Mode, (
+    BUFFERED,
+    SPLICE,
+    URING,
+    THREADED,
+    VECTORED
+  ))
+
+ public:
+  virtual ~Relay() {}
+
+  virtual void setCloseSinkOnEof(bool closeSinkOnEof) = 0;
+  virtual void setDiscardOnSinkError(bool discardOnSinkError) = 0;
+
+  virtual void start() = 0;
+
+  /// Stop reading, flush pending data and close sink.
+  virtual void close() = 0;
+
+  /// Drop pending data and close both ends.
+  virtual void terminate() = 0;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
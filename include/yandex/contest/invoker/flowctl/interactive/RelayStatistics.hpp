@@ -0,0 +1,139 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <utility>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Counters of a single relay direction.
+ *
+ * Histogram bucket i counts values v such that 2^(i-1) <= v < 2^i,
+ * bucket 0 counts zeros, the last bucket also counts everything above.
+ */
+struct RelayStatistics {
+  static constexpr std::size_t HISTOGRAM_SIZE = 32;
+  using Histogram = std::array<std::uintmax_t, HISTOGRAM_SIZE>;
+
+  std::uintmax_t bytesRead = 0;
+  std::uintmax_t bytesWritten = 0;
+  std::uintmax_t reads = 0;
+  std::uintmax_t writes = 0;
+
+  /// Maximum number of bytes read but not yet written.
+  std::uintmax_t maxBacklog = 0;
+
+  /// Sizes of chunks read from source, in bytes.
+  Histogram chunkSize{};
+
+  /// Time from chunk being read to its last byte being written, in us.
+  Histogram latency{};
+};
+
+/*!
+ * \brief Wall time split between conversation sides.
+ *
+ * Side's turn starts when the other side's data is written to it
+ * and ends when it produces output.
+ */
+struct ThinkTime {
+  std::chrono::nanoseconds interactor{0};
+  std::chrono::nanoseconds solution{0};
+
+  /// Number of completed turns.
+  std::uintmax_t interactorTurns = 0;
+  std::uintmax_t solutionTurns = 0;
+
+  /// Solution turns answered by interactor.
+  std::uintmax_t roundTrips() const {
+    return std::min(interactorTurns, solutionTurns);
+  }
+};
+
+/// Broker's resource usage while session was active.
+struct SessionStatistics {
+  RelayStatistics interactorToSolution;
+  RelayStatistics solutionToInteractor;
+  ThinkTime thinkTime;
+
+  /// Unset unless session is the only one in broker process.
+  boost::optional<std::chrono::microseconds> userTime;
+  boost::optional<std::chrono::microseconds> systemTime;
+};
+
+/// Collects RelayStatistics from relay read and write handlers.
+class RelayMonitor : private boost::noncopyable {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+ public:
+  void read(std::size_t size);
+  void write(std::size_t size);
+
+  const RelayStatistics &statistics() const { return statistics_; }
+
+ private:
+  RelayStatistics statistics_;
+
+  /// Stream offset of chunk end and time it was read.
+  std::deque<std::pair<std::uintmax_t, Clock::time_point>> pending_;
+};
+
+/// Tracks conversation turns, costs a clock read per chunk.
+class ThinkTimeMonitor : private boost::noncopyable {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+ public:
+  void interactorRead();
+  void interactorWritten();
+  void solutionRead();
+  void solutionWritten();
+
+  const ThinkTime &thinkTime() const { return thinkTime_; }
+
+ private:
+  enum class Turn { NONE, INTERACTOR, SOLUTION };
+
+  void endTurn(Turn turn, std::chrono::nanoseconds &time,
+               std::uintmax_t &turns);
+  void beginTurn(Turn turn);
+
+ private:
+  ThinkTime thinkTime_;
+  Turn turn_ = Turn::NONE;
+  Clock::time_point turnBegin_;
+};
+
+std::ostream &operator<<(std::ostream &out, const ThinkTime &thinkTime);
+
+boost::property_tree::ptree toPropertyTree(const RelayStatistics &statistics);
+boost::property_tree::ptree toPropertyTree(const ThinkTime &thinkTime);
+boost::property_tree::ptree toPropertyTree(
+    const SessionStatistics &statistics);
+
+/*!
+ * \brief Write tree as JSON, numeric values are not quoted.
+ *
+ * Nodes with empty keys are written as arrays.
+ */
+void writeJson(std::ostream &out, const boost::property_tree::ptree &tree);
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
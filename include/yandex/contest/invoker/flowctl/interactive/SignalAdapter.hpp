@@ -0,0 +1,96 @@
+#pragma once
+
+#include <boost/version.hpp>
+#if BOOST_VERSION < 106100
+#define BOOST_NO_CXX11_VARIADIC_TEMPLATES
+#endif
+
+#include <yandex/contest/invoker/flowctl/interactive/Event.hpp>
+
+#include <boost/signals2.hpp>
+
+#include <memory>
+#include <utility>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Forward event to boost::signals2::signal.
+ *
+ * Opt-in adapter for diagnostic listeners which need
+ * signals2 features like scoped connections.
+ * Signal must outlive the event.
+ */
+template <typename Signature>
+void connectSignal(Event<Signature> &event,
+                   boost::signals2::signal<Signature> &signal) {
+  event.connect(std::ref(signal));
+}
+
+/// signals2 types of the event, e.g. for BaseInterface::ErrorSignal.
+template <typename EventType>
+struct SignalTraits;
+
+template <typename Signature>
+struct SignalTraits<Event<Signature>> {
+  using Signal = boost::signals2::signal<Signature>;
+  using Slot = typename Signal::slot_type;
+  using ExtendedSlot = typename Signal::extended_slot_type;
+};
+
+namespace detail {
+/// Event slot owning a signal, so connections do not depend on caller.
+template <typename Signature>
+class SharedSignal {
+ public:
+  using Signal = typename SignalTraits<Event<Signature>>::Signal;
+
+ public:
+  SharedSignal() : signal_(std::make_shared<Signal>()) {}
+
+  template <typename... Args>
+  void operator()(Args &&... args) const {
+    (*signal_)(std::forward<Args>(args)...);
+  }
+
+  Signal &signal() const { return *signal_; }
+
+ private:
+  std::shared_ptr<Signal> signal_;
+};
+}  // namespace detail
+
+/*!
+ * \brief Connect signals2 slot, like signal::connect() used to.
+ *
+ * Disconnected slot is never called again,
+ * event itself keeps a no-op slot.
+ */
+template <typename Signature>
+boost::signals2::connection connectSlot(
+    Event<Signature> &event,
+    const typename SignalTraits<Event<Signature>>::Slot &slot) {
+  const detail::SharedSignal<Signature> shared;
+  event.connect(shared);
+  return shared.signal().connect(slot);
+}
+
+/// Slot receives its own connection as the first argument.
+template <typename Signature>
+boost::signals2::connection connectExtendedSlot(
+    Event<Signature> &event,
+    const typename SignalTraits<Event<Signature>>::ExtendedSlot &slot) {
+  const detail::SharedSignal<Signature> shared;
+  event.connect(shared);
+  return shared.signal().connect_extended(slot);
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
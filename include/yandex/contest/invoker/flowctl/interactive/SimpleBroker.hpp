@@ -1,12 +1,18 @@
 #pragma once
 
+#include <yandex/contest/invoker/flowctl/interactive/AsyncDump.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/BufferRelay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/Relay.hpp>
+
 #include <bunsan/stream_enum.hpp>
 
+#include <boost/asio/io_service.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
 
 #include <chrono>
+#include <functional>
 #include <string>
 
 namespace yandex {
@@ -27,8 +33,50 @@ class SimpleBroker : private boost::noncopyable {
     std::size_t outputLimitBytes = 0;
     std::chrono::milliseconds terminationRealTimeLimit{0};
 
+    Relay::Mode relayMode = Relay::Mode::BUFFERED;
+
+    /// Userspace relay buffer size in bytes, 0 keeps relay's default.
+    std::size_t relayBufferSize = 0;
+
+    /// Buffered relay doubles its buffers up to this size, 0 disables.
+    std::size_t maxRelayBufferSize = 0;
+
+    /// Capacity of all four pipes set with F_SETPIPE_SZ, 0 keeps default.
+    std::size_t pipeCapacity = 0;
+
+    /// Batch small writes of interactor or solution in buffered relay mode.
+    boost::optional<BufferRelay::CoalescingOptions> interactorCoalescing;
+    boost::optional<BufferRelay::CoalescingOptions> solutionCoalescing;
+
     boost::optional<boost::filesystem::path> dumpJudge;
     boost::optional<boost::filesystem::path> dumpSolution;
+
+    /// Write dumps from a separate thread, ignored in splice relay mode.
+    boost::optional<AsyncDump::Options> asyncDump;
+
+    /// JSON relay statistics written on completion, see SessionStatistics.
+    boost::optional<boost::filesystem::path> statistics;
+
+    /*!
+     * \brief Files opened by caller instead of paths above, -1 if unused.
+     *
+     * Owned by broker, corresponding path is used in messages only.
+     */
+    int dumpJudgeFd = -1;
+    int dumpSolutionFd = -1;
+    int statisticsFd = -1;
+
+    /*!
+     * \brief Latency profile, used by run() only.
+     *
+     * Execution loop polls for ready handlers without blocking
+     * for at most busyPollBudget before it blocks in epoll_wait,
+     * 0 disables busy polling.
+     */
+    std::chrono::microseconds busyPollBudget{0};
+
+    /// Pin thread calling run() to this CPU.
+    boost::optional<int> cpuAffinity;
   };
 
   BUNSAN_INCLASS_STREAM_ENUM_INITIALIZED(Status, (
@@ -45,10 +93,23 @@ class SimpleBroker : private boost::noncopyable {
     (SOLUTION_EXCESS_DATA, 105)
   ))
 
+  using Handler = std::function<void(Status)>;
+
   explicit SimpleBroker(const Options &options);
 
+  /// Runs session on its own execution loop.
   Status run();
 
+  /*!
+   * \brief Attaches session to caller's execution loop.
+   *
+   * Session handlers must be serialized,
+   * so ioService has to be run by a single thread.
+   * Handler is called from ioService when session is completed.
+   * SimpleBroker object may be destroyed before completion.
+   */
+  void async_run(boost::asio::io_service &ioService, const Handler &handler);
+
  private:
   Options options_;
 };
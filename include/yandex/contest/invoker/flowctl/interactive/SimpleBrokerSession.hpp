@@ -0,0 +1,152 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/BufferedConnection.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/SimpleBroker.hpp>
+
+#include <yandex/contest/invoker/Notifier.hpp>
+#include <yandex/contest/system/unistd/Descriptor.hpp>
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/optional.hpp>
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <sys/resource.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Single SimpleBroker session attached to execution loop.
+ *
+ * All handlers of a session must be serialized,
+ * so ioService has to be run by a single thread.
+ *
+ * When status is known, session waits for both EOFs
+ * at most for terminationRealTimeLimit, terminates connection
+ * and calls handler.
+ */
+class SimpleBrokerSession
+    : public std::enable_shared_from_this<SimpleBrokerSession>,
+      private boost::noncopyable {
+ public:
+  using Status = SimpleBroker::Status;
+  using Handler = SimpleBroker::Handler;
+
+ public:
+  SimpleBrokerSession(boost::asio::io_service &ioService,
+                      const SimpleBroker::Options &options);
+
+  /*!
+   * \brief Handler is called from ioService when session is completed.
+   *
+   * Session keeps itself alive until completion.
+   */
+  void start(const Handler &handler);
+
+  /*!
+   * \brief Report broker's CPU time in statistics.
+   *
+   * Resource usage is process-wide, so it is meaningful
+   * only if session is the only one in broker process.
+   */
+  void setMeasureResourceUsage(bool measureResourceUsage) {
+    measureResourceUsage_ = measureResourceUsage;
+  }
+
+  /*!
+   * \brief Complete session with FAILED status immediately.
+   *
+   * Used when an exception has escaped session's handler,
+   * session state may be inconsistent so connection is terminated
+   * without waiting for EOFs.
+   */
+  void fail(std::exception_ptr error);
+
+  /// Exception session has failed with, if any.
+  std::exception_ptr error() const { return error_; }
+
+ private:
+  struct TerminationTimer {
+    explicit TerminationTimer(boost::asio::io_service &ioService)
+        : timer(ioService) {}
+
+    template <typename Duration, typename F>
+    void async_wait(const Duration &duration, const F &f) {
+      std::call_once(flag, [this, duration, f]() {
+        timer.expires_from_now(duration);
+        timer.async_wait(f);
+      });
+    }
+
+    void cancel() {
+      std::call_once(flag, []() {});
+      timer.cancel();
+    }
+
+    boost::asio::steady_timer timer;
+    std::once_flag flag;
+  };
+
+  using Connection = BufferedConnection::Connection;
+
+  void result(Status status);
+  void complete();
+  void writeStatistics();
+
+  void waitForInteractorTermination();
+  void waitForSolutionTermination();
+
+  void handle_interactor_eof();
+  void handle_solution_eof();
+  void handle_interactor_termination(const process::Result &processResult);
+  void handle_solution_termination(const process::Result &processResult);
+
+  void handle_interactor_write_error(const boost::system::error_code &ec);
+
+ private:
+  boost::asio::io_service &ioService_;
+  const SimpleBroker::Options options_;
+  Handler handler_;
+  std::shared_ptr<SimpleBrokerSession> self_;
+
+  Connection solutionSource_;
+  Connection solutionSink_;
+  Connection interactorSource_;
+  Connection interactorSink_;
+  BufferedConnection connection_;
+  Notifier notifier_;
+
+  TerminationTimer interactorTerminationTimer_;
+  TerminationTimer solutionTerminationTimer_;
+  boost::asio::steady_timer completionTimer_;
+
+  boost::optional<Status> status_;
+  boost::optional<process::Result> interactorResult_;
+  boost::optional<process::Result> solutionResult_;
+
+  bool solutionExcessData_ = false;
+  bool interactorEof_ = false;
+  bool solutionEof_ = false;
+  bool completed_ = false;
+
+  std::exception_ptr error_;
+
+  bool measureResourceUsage_ = false;
+  rusage startUsage_;
+
+  /// Opened by caller, see SimpleBroker::Options::statisticsFd.
+  system::unistd::Descriptor statisticsFile_;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
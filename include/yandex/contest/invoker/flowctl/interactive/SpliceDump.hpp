@@ -0,0 +1,66 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/Relay.hpp>
+
+#include <yandex/contest/system/unistd/Descriptor.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Dump file fed through a pipe.
+ *
+ * Relay duplicates data into sink() with tee(2),
+ * dedicated thread splices pipe contents into the file,
+ * so slow disk never blocks execution loop.
+ */
+class SpliceDump : private boost::noncopyable {
+ public:
+  SpliceDump(boost::asio::io_service &ioService,
+             const boost::filesystem::path &path);
+
+  /// Write into already opened file.
+  SpliceDump(boost::asio::io_service &ioService,
+             system::unistd::Descriptor file);
+
+  /// Closes sink and waits for the file to be written.
+  ~SpliceDump();
+
+  /// Write end of the pipe.
+  Relay::Connection &sink() { return sink_; }
+
+  /// No more data will be written.
+  void close();
+
+  /// Some data was lost, AsyncDump::TRUNCATION_MARKER is appended.
+  void markTruncated() { truncated_ = true; }
+
+ private:
+  void run();
+
+  /// \return whether everything was written
+  bool copy();
+
+  void drain();
+
+ private:
+  Relay::Connection sink_;
+  system::unistd::Descriptor source_;
+  system::unistd::Descriptor file_;
+  std::atomic<bool> truncated_{false};
+  std::thread thread_;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
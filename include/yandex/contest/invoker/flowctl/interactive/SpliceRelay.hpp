@@ -0,0 +1,110 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/Relay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/SpliceDump.hpp>
+
+#include <yandex/contest/system/unistd/Descriptor.hpp>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Zero-copy relay, moves data source > pipe > sink using splice(2).
+ *
+ * Data never reaches userspace, handlers receive byte counts only.
+ * Dump receives a tee(2) copy of either read or written data.
+ * Data left in the relay when it finishes is moved into dump
+ * within a short timeout, otherwise dump is marked truncated.
+ */
+class SpliceRelay : public Relay {
+ public:
+  SpliceRelay(Connection &source, Connection &sink,
+              const Handler &readHandler, const Handler &writeHandler);
+
+  /*!
+   * \brief Whether both file descriptors may be spliced.
+   *
+   * \param writeDump written data is teed into sink,
+   * so it has to be a pipe
+   */
+  static bool isSupported(Connection &source, Connection &sink,
+                          bool writeDump = false);
+
+  /*!
+   * \brief Grow intermediate pipe using F_SETPIPE_SZ.
+   *
+   * \return capacity actually applied
+   */
+  std::size_t setCapacity(std::size_t capacity);
+
+  /// Dump everything read from source.
+  void setReadDump(SpliceDump &dump);
+
+  /// Dump everything written into sink.
+  void setWriteDump(SpliceDump &dump);
+
+  void setCloseSinkOnEof(bool closeSinkOnEof) override;
+  void setDiscardOnSinkError(bool discardOnSinkError) override;
+
+  void start() override;
+  void close() override;
+  void terminate() override;
+
+ private:
+  void read();
+  void handle_source_ready(const boost::system::error_code &ec);
+
+  void write();
+  void handle_sink_ready(const boost::system::error_code &ec);
+  void handle_dump_ready(const boost::system::error_code &ec);
+  void handle_sink_error(const boost::system::error_code &ec);
+  void dumpFailed(const boost::system::error_code &ec);
+
+  bool tee();
+  bool flush();
+  void wait(Connection &connection);
+
+  void drain(std::size_t size);
+  void flushDump();
+  void finish();
+
+ private:
+  enum Target { SINK, DUMP, NONE };
+
+ private:
+  Connection &source_;
+  Connection &sink_;
+  const Handler readHandler_;
+  const Handler writeHandler_;
+
+  system::unistd::Descriptor pipeReadEnd_;
+  system::unistd::Descriptor pipeWriteEnd_;
+  std::size_t capacity_;
+
+  bool closeSinkOnEof_ = true;
+  bool discardOnSinkError_ = false;
+
+  SpliceDump *dump_ = nullptr;
+  bool dumpWritten_ = false;
+
+  /// Bytes in intermediate pipe.
+  std::size_t pending_ = 0;
+
+  /// Leading pending bytes already teed, they have to be moved to owedTarget_.
+  std::size_t owed_ = 0;
+  Target owedTarget_ = NONE;
+
+  bool eof_ = false;
+  bool sinkFailed_ = false;
+  bool closing_ = false;
+  bool finished_ = false;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include <cstring>
+
+#include <sys/uio.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Lock-free single-producer single-consumer byte ring.
+ *
+ * Memory is allocated once, capacity is rounded up to a power of two.
+ * Producer and consumer positions live on separate cache lines.
+ */
+class SpscRingBuffer : private boost::noncopyable {
+ public:
+  static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+ public:
+  explicit SpscRingBuffer(const std::size_t capacity)
+      : capacity_(roundUp(capacity)),
+        mask_(capacity_ - 1),
+        buffer_(new char[capacity_]) {}
+
+  std::size_t capacity() const { return capacity_; }
+
+  std::size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return !size(); }
+  bool full() const { return size() == capacity_; }
+
+  // producer
+
+  /// \return number of bytes copied
+  std::size_t push(const char *const data, const std::size_t size) {
+    iovec parts[2];
+    const int count = writable(parts);
+    std::size_t pushed = 0;
+    for (int i = 0; i < count && pushed < size; ++i) {
+      const std::size_t part = std::min(parts[i].iov_len, size - pushed);
+      std::memcpy(parts[i].iov_base, data + pushed, part);
+      pushed += part;
+    }
+    produce(pushed);
+    return pushed;
+  }
+
+  /// Free space, at most two contiguous parts.
+  int writable(iovec (&parts)[2]) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    return split(tail, capacity_ - (tail - head), parts);
+  }
+
+  /// Publish size bytes written into writable() parts.
+  void produce(const std::size_t size) {
+    tail_.store(tail_.load(std::memory_order_relaxed) + size,
+                std::memory_order_release);
+  }
+
+  // consumer
+
+  /// Stored data, at most two contiguous parts.
+  int readable(iovec (&parts)[2]) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t tail = tail_.load(std::memory_order_acquire);
+    return split(head, tail - head, parts);
+  }
+
+  /// Release size bytes obtained from readable() parts.
+  void consume(const std::size_t size) {
+    head_.store(head_.load(std::memory_order_relaxed) + size,
+                std::memory_order_release);
+  }
+
+ private:
+  static std::size_t roundUp(const std::size_t capacity) {
+    std::size_t result = 1;
+    while (result < capacity) result <<= 1;
+    return result;
+  }
+
+  int split(const std::size_t position, const std::size_t size,
+            iovec (&parts)[2]) {
+    if (!size) return 0;
+    const std::size_t offset = position & mask_;
+    const std::size_t first = std::min(size, capacity_ - offset);
+    parts[0].iov_base = buffer_.get() + offset;
+    parts[0].iov_len = first;
+    if (first == size) return 1;
+    parts[1].iov_base = buffer_.get();
+    parts[1].iov_len = size - first;
+    return 2;
+  }
+
+ private:
+  const std::size_t capacity_;
+  const std::size_t mask_;
+  const std::unique_ptr<char[]> buffer_;
+
+  char headPadding_[CACHE_LINE_SIZE];
+  /// Consumer position.
+  std::atomic<std::size_t> head_{0};
+
+  char tailPadding_[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+  /// Producer position.
+  std::atomic<std::size_t> tail_{0};
+
+  char endPadding_[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
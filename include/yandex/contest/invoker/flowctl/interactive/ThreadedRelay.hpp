@@ -0,0 +1,124 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/Relay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/SpscRingBuffer.hpp>
+
+#include <yandex/contest/system/unistd/Descriptor.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <thread>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Relay with dedicated reader and writer threads.
+ *
+ * Threads are connected by a lock-free SpscRingBuffer
+ * and sleep in poll(2) only when ring or descriptor is not ready.
+ *
+ * Handlers are invoked from io_service, byte counts
+ * accumulated while a notification is queued are coalesced
+ * into a single call. Data handlers are invoked from relay threads,
+ * exception thrown by a data handler stops both threads
+ * and is reported to read handler as an error,
+ * since nothing is read any more.
+ */
+class ThreadedRelay : public Relay {
+ public:
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+ public:
+  ThreadedRelay(Connection &source, Connection &sink,
+                const Handler &readHandler, const Handler &writeHandler,
+                std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /// Stops threads, does not close connections.
+  ~ThreadedRelay() override;
+
+  /// Called from reader thread.
+  void setReadDataHandler(const DataHandler &handler) {
+    readDataHandler_ = handler;
+  }
+
+  /// Called from writer thread.
+  void setWriteDataHandler(const DataHandler &handler) {
+    writeDataHandler_ = handler;
+  }
+
+  /// Reader thread stops as soon as more than limit bytes are read.
+  void setReadLimit(const std::uintmax_t limit) { readLimit_ = limit; }
+
+  void setCloseSinkOnEof(bool closeSinkOnEof) override;
+  void setDiscardOnSinkError(bool discardOnSinkError) override;
+
+  void start() override;
+  void close() override;
+  void terminate() override;
+
+  /// May be called from any thread.
+  std::uintmax_t bytesRead() const { return bytesRead_.load(); }
+  std::uintmax_t bytesWritten() const { return bytesWritten_.load(); }
+
+ private:
+  /// State shared with queued notifications.
+  struct Notifier;
+
+  /// Thread-specific wake up.
+  struct Side {
+    system::unistd::Descriptor wakeup;
+    std::atomic<bool> waiting{false};
+  };
+
+  void readLoop();
+  void writeLoop();
+
+  /// Stop both threads and report error to read handler.
+  void fail(std::exception_ptr error);
+
+  template <typename Predicate>
+  void sleep(Side &side, int fd, short events, const Predicate &ready);
+  void wake(Side &side);
+  void interrupt(Side &side);
+
+  void stopThreads();
+
+ private:
+  Connection &source_;
+  Connection &sink_;
+  const std::shared_ptr<Notifier> notifier_;
+
+  DataHandler readDataHandler_;
+  DataHandler writeDataHandler_;
+  std::uintmax_t readLimit_ = std::numeric_limits<std::uintmax_t>::max();
+  bool closeSinkOnEof_ = true;
+  bool discardOnSinkError_ = false;
+
+  SpscRingBuffer buffer_;
+  Side reader_;
+  Side writer_;
+
+  std::atomic<std::uintmax_t> bytesRead_{0};
+  std::atomic<std::uintmax_t> bytesWritten_{0};
+
+  /// Reader has finished, nothing will be produced.
+  std::atomic<bool> sourceDone_{false};
+  std::atomic<bool> closing_{false};
+  std::atomic<bool> stopping_{false};
+
+  std::thread readerThread_;
+  std::thread writerThread_;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/IoUring.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/Relay.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief io_uring instance attached to asio execution loop.
+ *
+ * Completions are signalled through eventfd,
+ * so other asio objects (notifier, timers) keep working.
+ * Execution loop is held only while operations are in flight.
+ */
+class UringLoop : private boost::noncopyable {
+ public:
+  class Operation {
+   public:
+    virtual void complete(int result) = 0;
+
+   protected:
+    ~Operation() {}
+  };
+
+ public:
+  /// Allocates and registers bufferCount fixed buffers.
+  UringLoop(boost::asio::io_service &ioService, unsigned entries,
+            std::size_t bufferCount, std::size_t bufferSize);
+
+  std::size_t bufferSize() const { return bufferSize_; }
+  char *buffer(const std::size_t index) { return buffers_[index].get(); }
+
+  /// \return zeroed entry with user_data set to operation
+  io_uring_sqe *getSqe(Operation *operation);
+
+  /// Cancel operation, completion is delivered with -ECANCELED.
+  void cancel(Operation &operation);
+
+  void submit();
+
+  /// Stop delivering completions.
+  void close();
+
+ private:
+  void wait();
+  void handle_event(const boost::system::error_code &ec);
+
+  /// Deliver available completions.
+  void drain();
+
+  /// Completions can't be waited for, complete pending operations with ec.
+  void fail(const boost::system::error_code &ec);
+
+ private:
+  /// Registered buffers outlive ring, canceled operations may be in flight.
+  const std::size_t bufferSize_;
+  std::vector<std::unique_ptr<char[]>> buffers_;
+
+  IoUring ring_;
+  Relay::Connection event_;
+  std::uint64_t eventValue_ = 0;
+  bool waiting_ = false;
+  std::size_t inFlight_ = 0;
+
+  /// Operations in flight, cancellations are not tracked.
+  std::vector<Operation *> pending_;
+};
+
+/*!
+ * \brief Relay on top of io_uring with registered buffers.
+ *
+ * Write of a chunk and read of the next one are linked
+ * and passed to the kernel by a single io_uring_enter(2).
+ */
+class UringRelay : public Relay {
+ public:
+  UringRelay(UringLoop &loop, std::size_t bufferIndex, Connection &source,
+             Connection &sink, const Handler &readHandler,
+             const Handler &writeHandler);
+
+  void setCloseSinkOnEof(bool closeSinkOnEof) override;
+  void setDiscardOnSinkError(bool discardOnSinkError) override;
+
+  void setReadDataHandler(const DataHandler &handler) {
+    readDataHandler_ = handler;
+  }
+
+  void setWriteDataHandler(const DataHandler &handler) {
+    writeDataHandler_ = handler;
+  }
+
+  void start() override;
+  void close() override;
+  void terminate() override;
+
+ private:
+  template <void (UringRelay::*Handle)(int)>
+  struct Operation : UringLoop::Operation {
+    explicit Operation(UringRelay *relay) : relay(relay) {}
+    void complete(const int result) override { (relay->*Handle)(result); }
+    UringRelay *const relay;
+  };
+
+  void prepareRead();
+  void prepareWrite(bool link);
+  void preparePoll(int fd, short events);
+
+  void handle_read(int result);
+  void handle_write(int result);
+  void handle_poll(int result);
+
+  void finish();
+
+ private:
+  UringLoop &loop_;
+  const std::size_t bufferIndex_;
+  char *const buffer_;
+
+  Connection &source_;
+  Connection &sink_;
+  const Handler readHandler_;
+  const Handler writeHandler_;
+  DataHandler readDataHandler_;
+  DataHandler writeDataHandler_;
+
+  Operation<&UringRelay::handle_read> readOperation_{this};
+  Operation<&UringRelay::handle_write> writeOperation_{this};
+  Operation<&UringRelay::handle_poll> pollOperation_{this};
+
+  bool closeSinkOnEof_ = true;
+  bool discardOnSinkError_ = false;
+
+  std::size_t reads_ = 0;
+  std::size_t writes_ = 0;
+  std::size_t polls_ = 0;
+
+  /// Events of the last submitted poll, selects handler for its errors.
+  short pollEvents_ = 0;
+
+  /// Buffer contents, [written_, size_) is pending.
+  std::size_t size_ = 0;
+  std::size_t written_ = 0;
+
+  bool sinkFailed_ = false;
+  bool closing_ = false;
+  bool finished_ = false;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
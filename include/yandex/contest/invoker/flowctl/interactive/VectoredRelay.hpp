@@ -0,0 +1,94 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/Relay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/SpscRingBuffer.hpp>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+/*!
+ * \brief Userspace relay moving whole bursts per readiness event.
+ *
+ * On every readiness notification source is read with readv(2)
+ * until EAGAIN or until ring is full, everything pending
+ * is flushed into sink with writev(2). Relay waits for readiness
+ * only after EAGAIN, so edge-triggered notifications are sufficient.
+ *
+ * Read handler is called for every readv(2) with exact byte count,
+ * relay stops as soon as a handler has terminated it.
+ */
+class VectoredRelay : public Relay {
+ public:
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE = 256 * 1024;
+
+ public:
+  VectoredRelay(Connection &source, Connection &sink,
+                const Handler &readHandler, const Handler &writeHandler,
+                std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  void setReadDataHandler(const DataHandler &handler) {
+    readDataHandler_ = handler;
+  }
+
+  void setWriteDataHandler(const DataHandler &handler) {
+    writeDataHandler_ = handler;
+  }
+
+  void setCloseSinkOnEof(bool closeSinkOnEof) override;
+  void setDiscardOnSinkError(bool discardOnSinkError) override;
+
+  void start() override;
+  void close() override;
+  void terminate() override;
+
+ private:
+  /// Move data until both sides would block.
+  void pump();
+
+  /// \return whether anything was read
+  bool drain();
+
+  /// \return whether anything was written
+  bool flush();
+
+  void handle_source_ready(const boost::system::error_code &ec);
+  void handle_sink_ready(const boost::system::error_code &ec);
+
+  void finish();
+
+ private:
+  Connection &source_;
+  Connection &sink_;
+  const Handler readHandler_;
+  const Handler writeHandler_;
+  DataHandler readDataHandler_;
+  DataHandler writeDataHandler_;
+
+  bool closeSinkOnEof_ = true;
+  bool discardOnSinkError_ = false;
+
+  /// Used by a single thread, positions are never contended.
+  SpscRingBuffer buffer_;
+
+  /// Last system call has returned EAGAIN.
+  bool sourceBlocked_ = false;
+  bool sinkBlocked_ = false;
+
+  bool sourceWaiting_ = false;
+  bool sinkWaiting_ = false;
+
+  bool pumping_ = false;
+  bool sourceDone_ = false;
+  bool sinkFailed_ = false;
+  bool closing_ = false;
+  bool finished_ = false;
+};
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
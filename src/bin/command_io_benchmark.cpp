@@ -0,0 +1,202 @@
+#include <yandex/contest/invoker/flowctl/interactive/Error.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/PercentEncoding.hpp>
+
+#include <bunsan/runtime/demangle.hpp>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+using namespace yandex::contest::invoker::flowctl::interactive;
+using Clock = std::chrono::steady_clock;
+
+bool isDigit(const char c) { return '0' <= c && c <= '9'; }
+
+bool isPermitted(const char c) {
+  return isDigit(c) || ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+         c == '_';
+}
+
+/// Byte-by-byte ostringstream encoder CommandIo used to have.
+std::string referenceEncode(const std::string &value) {
+  std::ostringstream sout;
+  for (const char c : value) {
+    if (isPermitted(c)) {
+      sout << c;
+    } else {
+      sout << '%' << std::hex << std::setw(2) << std::setfill('0')
+           << static_cast<unsigned>(static_cast<unsigned char>(c));
+    }
+  }
+  return sout.str();
+}
+
+/// Byte-by-byte ostringstream decoder CommandIo used to have, verbatim.
+std::string referenceDecode(const std::string &data) {
+  try {
+    std::ostringstream sout;
+    int complexPos = 0;
+    unsigned buf = 0;
+    for (const char c : data) {
+      switch (complexPos) {
+        case 0:
+          switch (c) {
+            case '%':
+              complexPos = 2;
+              break;
+            default:
+              if (!isPermitted(c))
+                BOOST_THROW_EXCEPTION(
+                    DecodeCommandValueCharacterIsNotPermittedError()
+                    << DecodeCommandValueCharacterIsNotPermittedError::
+                        character(c));
+              sout << c;
+          }
+          break;
+        case 1:
+          if (!isDigit(c))
+            BOOST_THROW_EXCEPTION(
+                DecodeCommandValueDigitExpectedError()
+                << DecodeCommandValueDigitExpectedError::character(c));
+          buf += c - '0';
+          sout << static_cast<char>(static_cast<unsigned char>(buf));
+          complexPos = 0;
+          break;
+        case 2:
+          if (!isDigit(c))
+            BOOST_THROW_EXCEPTION(
+                DecodeCommandValueDigitExpectedError()
+                << DecodeCommandValueDigitExpectedError::character(c));
+          buf = 0x10 * (c - '0');
+          complexPos = 1;
+          break;
+      }
+    }
+    if (complexPos)
+      BOOST_THROW_EXCEPTION(
+          DecodeCommandValueError()
+          << DecodeCommandValueError::data(data)
+          << DecodeCommandValueError::message("Invalid escape sequence."));
+    return sout.str();
+  } catch (DecodeCommandValueError &) {
+    throw;
+  } catch (std::exception &) {
+    BOOST_THROW_EXCEPTION(DecodeCommandValueError()
+                          << DecodeCommandValueError::data(data)
+                          << bunsan::enable_nested_current());
+  }
+}
+
+std::string makePayload(const std::size_t size, const double escapedShare) {
+  std::mt19937 generator(0);
+  std::bernoulli_distribution escaped(escapedShare);
+  std::string payload(size, '\0');
+  for (char &c : payload) {
+    // reference decoder accepts decimal digits only in escape sequences
+    c = escaped(generator)
+            ? static_cast<char>(0x10 * (generator() % 2) + generator() % 10)
+            : static_cast<char>('a' + generator() % 26);
+  }
+  return payload;
+}
+
+template <typename F>
+double megabytesPerSecond(const std::size_t bytes, const std::size_t rounds,
+                          const F &f) {
+  const Clock::time_point begin = Clock::now();
+  for (std::size_t i = 0; i < rounds; ++i) f();
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - begin).count();
+  return bytes * rounds / seconds / (1024 * 1024);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::size_t size = 1024 * 1024;
+  std::size_t rounds = 100;
+  std::string output;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Usage");
+  try {
+    desc.add_options()(
+        "size", po::value<std::size_t>(&size), "payload size in bytes"
+    )(
+        "rounds", po::value<std::size_t>(&rounds), "number of rounds"
+    )(
+        "output", po::value<std::string>(&output),
+        "write JSON results into file instead of stdout"
+    );
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    po::notify(vm);
+
+    const std::vector<std::pair<std::string, double>> payloads = {
+        {"clean", 0.01}, {"escaped", 0.9}};
+    using Implementation = PercentEncoding::Implementation;
+
+    boost::property_tree::ptree results;
+    for (const auto &payloadType : payloads) {
+      const std::string payload =
+          makePayload(size, payloadType.second);
+      const std::string encoded = referenceEncode(payload);
+      std::string buffer(3 * size, '\0'), reference;
+      const std::string prefix = payloadType.first + ".";
+
+      std::cerr << "Running " << payloadType.first << "..." << std::endl;
+      results.put(prefix + "reference.encode",
+                  megabytesPerSecond(size, rounds, [&] {
+                    reference = referenceEncode(payload);
+                  }));
+      results.put(prefix + "reference.decode",
+                  megabytesPerSecond(size, rounds, [&] {
+                    reference = referenceDecode(encoded);
+                  }));
+
+      for (const Implementation implementation :
+           {Implementation::SCALAR, Implementation::SSE2,
+            Implementation::AVX2}) {
+        if (!PercentEncoding::isSupported(implementation)) continue;
+        const PercentEncoding encoding(implementation);
+        const std::string name =
+            prefix + boost::lexical_cast<std::string>(implementation);
+
+        results.put(name + ".encode", megabytesPerSecond(size, rounds, [&] {
+                      encoding.encode(payload.data(), payload.size(),
+                                      &buffer[0]);
+                    }));
+        results.put(name + ".decode", megabytesPerSecond(size, rounds, [&] {
+                      std::size_t decodedSize;
+                      boost::system::error_code ec;
+                      encoding.decode(encoded.data(), encoded.size(),
+                                      &buffer[0], decodedSize, ec);
+                    }));
+      }
+    }
+
+    if (output.empty())
+      boost::property_tree::write_json(std::cout, results);
+    else
+      boost::property_tree::write_json(output, results);
+  } catch (po::error &e) {
+    std::cerr << e.what() << std::endl
+              << desc << std::endl;
+    return 200;
+  } catch (std::exception &e) {
+    std::cerr << "Program terminated due to exception of type \""
+              << bunsan::runtime::type_name(e) << "\"." << std::endl;
+    std::cerr << "what() returns the following message:" << std::endl
+              << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,378 @@
+#include <yandex/contest/invoker/flowctl/interactive/BufferedConnection.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/Error.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/RelayStatistics.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/SimpleBroker.hpp>
+
+#include <yandex/contest/SystemError.hpp>
+#include <yandex/contest/system/unistd/Pipe.hpp>
+
+#include <bunsan/filesystem/fstream.hpp>
+#include <bunsan/runtime/demangle.hpp>
+#include <bunsan/stream_enum.hpp>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+using namespace yandex::contest::invoker::flowctl::interactive;
+using yandex::contest::SystemError;
+using yandex::contest::system::unistd::Descriptor;
+using yandex::contest::system::unistd::Pipe;
+using Clock = std::chrono::steady_clock;
+
+BUNSAN_STREAM_ENUM_CLASS(Target, (
+  CONNECTION,
+  BROKER
+))
+
+void writeAll(const int fd, const char *data, std::size_t size) {
+  while (size) {
+    const ssize_t written = ::write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      BOOST_THROW_EXCEPTION(SystemError("write"));
+    }
+    data += written;
+    size -= written;
+  }
+}
+
+void readAll(const int fd, char *data, std::size_t size) {
+  while (size) {
+    const ssize_t received = ::read(fd, data, size);
+    if (received < 0) {
+      if (errno == EINTR) continue;
+      BOOST_THROW_EXCEPTION(SystemError("read"));
+    }
+    if (!received)
+      BOOST_THROW_EXCEPTION(Error()
+                            << Error::message("Unexpected end of file"));
+    data += received;
+    size -= received;
+  }
+}
+
+struct Workload {
+  std::string name;
+
+  /// Empty means streaming from interactor to solution.
+  std::vector<std::size_t> messageSizes;
+
+  std::size_t messages;
+};
+
+struct Endpoints {
+  /// Read by broker.
+  Descriptor interactorOutput, solutionOutput;
+
+  /// Written by broker.
+  Descriptor interactorInput, solutionInput;
+};
+
+struct Result {
+  std::chrono::nanoseconds time{0};
+  std::uintmax_t messages = 0;
+  std::uintmax_t bytes = 0;
+  std::vector<std::chrono::nanoseconds> roundTrips;
+};
+
+void runInteractor(Endpoints &endpoints, const Workload &workload,
+                   Result &result) {
+  std::vector<char> buffer(
+      *std::max_element(workload.messageSizes.begin(),
+                        workload.messageSizes.end()),
+      'x');
+  result.roundTrips.reserve(workload.messages);
+  for (std::size_t i = 0; i < workload.messages; ++i) {
+    const std::size_t size =
+        workload.messageSizes[i % workload.messageSizes.size()];
+    const Clock::time_point begin = Clock::now();
+    writeAll(endpoints.interactorOutput.get(), buffer.data(), size);
+    readAll(endpoints.interactorInput.get(), buffer.data(), size);
+    result.roundTrips.push_back(Clock::now() - begin);
+    result.bytes += 2 * size;
+  }
+  result.messages = workload.messages;
+}
+
+void runSolution(Endpoints &endpoints, const Workload &workload) {
+  std::vector<char> buffer(*std::max_element(workload.messageSizes.begin(),
+                                             workload.messageSizes.end()));
+  for (std::size_t i = 0; i < workload.messages; ++i) {
+    const std::size_t size =
+        workload.messageSizes[i % workload.messageSizes.size()];
+    readAll(endpoints.solutionInput.get(), buffer.data(), size);
+    writeAll(endpoints.solutionOutput.get(), buffer.data(), size);
+  }
+}
+
+constexpr std::size_t STREAM_CHUNK_SIZE = 64 * 1024;
+
+void runStreamingInteractor(Endpoints &endpoints, const Workload &workload,
+                            Result &result) {
+  const std::vector<char> buffer(STREAM_CHUNK_SIZE, 'x');
+  for (std::size_t i = 0; i < workload.messages; ++i)
+    writeAll(endpoints.interactorOutput.get(), buffer.data(), buffer.size());
+  // wait for solution to receive everything
+  char ack;
+  readAll(endpoints.interactorInput.get(), &ack, 1);
+  result.messages = workload.messages;
+  result.bytes = workload.messages * STREAM_CHUNK_SIZE;
+}
+
+void runStreamingSolution(Endpoints &endpoints, const Workload &workload) {
+  std::vector<char> buffer(STREAM_CHUNK_SIZE);
+  for (std::size_t i = 0; i < workload.messages; ++i)
+    readAll(endpoints.solutionInput.get(), buffer.data(), buffer.size());
+  const char ack = 0;
+  writeAll(endpoints.solutionOutput.get(), &ack, 1);
+}
+
+/// Broker side of the pipes, owned by broker after start.
+struct BrokerFds {
+  int interactorSource, interactorSink, solutionSource, solutionSink;
+};
+
+std::thread startConnection(
+    const BrokerFds &fds, const Relay::Mode relayMode,
+    const boost::optional<boost::filesystem::path> &dir) {
+  return std::thread([fds, relayMode, dir] {
+    boost::asio::io_service ioService;
+    BufferedConnection::Connection interactorSource(ioService,
+                                                    fds.interactorSource);
+    BufferedConnection::Connection interactorSink(ioService,
+                                                  fds.interactorSink);
+    BufferedConnection::Connection solutionSource(ioService,
+                                                  fds.solutionSource);
+    BufferedConnection::Connection solutionSink(ioService, fds.solutionSink);
+    BufferedConnection connection(interactorSource, interactorSink,
+                                  solutionSource, solutionSink,
+                                  std::numeric_limits<std::size_t>::max());
+    connection.setRelayMode(relayMode);
+    if (dir) {
+      connection.setDumpJudge(*dir / "judge");
+      connection.setDumpSolution(*dir / "solution");
+    }
+
+    bool interactorEof = false, solutionEof = false;
+    connection.interactorEof.connect([&] {
+      interactorEof = true;
+      if (solutionEof) connection.terminate();
+    });
+    connection.solutionEof.connect([&] {
+      solutionEof = true;
+      if (interactorEof) connection.terminate();
+    });
+
+    connection.start();
+    ioService.run();
+    connection.flushDumps();
+  });
+}
+
+/// Notifier pipe stays silent, session ends by termination timeout.
+std::thread startBroker(const BrokerFds &fds, const int notifierFd,
+                        const Relay::Mode relayMode,
+                        const boost::optional<boost::filesystem::path> &dir) {
+  SimpleBroker::Options options;
+  options.notifierFd = notifierFd;
+  options.interactorSourceFd = fds.interactorSource;
+  options.interactorSinkFd = fds.interactorSink;
+  options.solutionSourceFd = fds.solutionSource;
+  options.solutionSinkFd = fds.solutionSink;
+  options.outputLimitBytes = std::numeric_limits<std::size_t>::max();
+  options.terminationRealTimeLimit = std::chrono::milliseconds(1);
+  options.relayMode = relayMode;
+  if (dir) {
+    options.dumpJudge = *dir / "judge";
+    options.dumpSolution = *dir / "solution";
+  }
+  return std::thread([options] {
+    SimpleBroker broker(options);
+    broker.run();
+  });
+}
+
+Result runWorkload(const Target target, const Relay::Mode relayMode,
+                   const boost::optional<boost::filesystem::path> &dumpDir,
+                   const Workload &workload) {
+  Endpoints endpoints;
+  BrokerFds fds;
+  {
+    Pipe pipe;
+    endpoints.interactorOutput = pipe.releaseWriteEnd();
+    fds.interactorSource = pipe.releaseReadEnd().release();
+  }
+  {
+    Pipe pipe;
+    endpoints.interactorInput = pipe.releaseReadEnd();
+    fds.interactorSink = pipe.releaseWriteEnd().release();
+  }
+  {
+    Pipe pipe;
+    endpoints.solutionOutput = pipe.releaseWriteEnd();
+    fds.solutionSource = pipe.releaseReadEnd().release();
+  }
+  {
+    Pipe pipe;
+    endpoints.solutionInput = pipe.releaseReadEnd();
+    fds.solutionSink = pipe.releaseWriteEnd().release();
+  }
+
+  Pipe notifier;
+  std::thread broker =
+      target == Target::CONNECTION
+          ? startConnection(fds, relayMode, dumpDir)
+          : startBroker(fds, notifier.releaseReadEnd().release(), relayMode,
+                        dumpDir);
+
+  Result result;
+  const bool streaming = workload.messageSizes.empty();
+  const Clock::time_point begin = Clock::now();
+  std::thread solution([&] {
+    if (streaming)
+      runStreamingSolution(endpoints, workload);
+    else
+      runSolution(endpoints, workload);
+  });
+  if (streaming)
+    runStreamingInteractor(endpoints, workload, result);
+  else
+    runInteractor(endpoints, workload, result);
+  solution.join();
+  result.time = Clock::now() - begin;
+
+  endpoints = Endpoints();
+  broker.join();
+  return result;
+}
+
+boost::property_tree::ptree report(const Result &result) {
+  using Seconds = std::chrono::duration<double>;
+  using Microseconds = std::chrono::duration<double, std::micro>;
+  const double seconds = Seconds(result.time).count();
+
+  boost::property_tree::ptree tree;
+  tree.put("seconds", seconds);
+  tree.put("messages", result.messages);
+  tree.put("bytes", result.bytes);
+  tree.put("messagesPerSecond", result.messages / seconds);
+  tree.put("megabytesPerSecond", result.bytes / seconds / (1024 * 1024));
+
+  std::vector<std::chrono::nanoseconds> roundTrips = result.roundTrips;
+  if (!roundTrips.empty()) {
+    std::sort(roundTrips.begin(), roundTrips.end());
+    const auto percentile = [&roundTrips](const double p) {
+      const std::size_t index = std::min<std::size_t>(
+          roundTrips.size() * p, roundTrips.size() - 1);
+      return Microseconds(roundTrips[index]).count();
+    };
+    tree.put("roundTripMicroseconds.p50", percentile(0.5));
+    tree.put("roundTripMicroseconds.p99", percentile(0.99));
+    tree.put("roundTripMicroseconds.p999", percentile(0.999));
+  }
+  return tree;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::vector<Target> targets;
+  Relay::Mode relayMode = Relay::Mode::BUFFERED;
+  std::string dumpDir = boost::filesystem::temp_directory_path().string();
+  std::string output;
+  double scale = 1;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Usage");
+  try {
+    desc.add_options()(
+        "target", po::value<std::vector<Target>>(&targets)->composing(),
+        "CONNECTION or BROKER, may be repeated, both by default"
+    )(
+        "relay-mode", po::value<Relay::Mode>(&relayMode),
+        "relay mode: BUFFERED, SPLICE, URING, THREADED or VECTORED"
+    )(
+        "dump-dir", po::value<std::string>(&dumpDir),
+        "directory for dumps of runs with dumps enabled"
+    )(
+        "scale", po::value<double>(&scale),
+        "multiplier for number of messages"
+    )(
+        "output", po::value<std::string>(&output),
+        "write JSON results into file instead of stdout"
+    );
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    po::notify(vm);
+    if (targets.empty()) targets = {Target::CONNECTION, Target::BROKER};
+
+    std::vector<std::size_t> lineSizes;
+    {
+      std::mt19937 generator(0);
+      std::uniform_int_distribution<std::size_t> size(8, 256);
+      for (std::size_t i = 0; i < 1024; ++i)
+        lineSizes.push_back(size(generator));
+    }
+    const auto messages = [scale](const std::size_t count) {
+      return std::max<std::size_t>(count * scale, 1);
+    };
+    const std::vector<Workload> workloads = {
+        {"ping-pong", {1}, messages(100000)},
+        {"streaming", {}, messages(4096)},
+        {"lines", lineSizes, messages(100000)},
+    };
+
+    boost::property_tree::ptree results;
+    results.put("relayMode", boost::lexical_cast<std::string>(relayMode));
+    for (const Target target : targets) {
+      for (const Workload &workload : workloads) {
+        for (const bool dump : {false, true}) {
+          boost::optional<boost::filesystem::path> dir;
+          if (dump) dir = boost::filesystem::path(dumpDir);
+          const std::string name = boost::lexical_cast<std::string>(target) +
+                                   "." + workload.name +
+                                   (dump ? ".dump" : ".nodump");
+          std::cerr << "Running " << name << "..." << std::endl;
+          results.put_child(
+              boost::property_tree::ptree::path_type(name, '/'),
+              report(runWorkload(target, relayMode, dir, workload)));
+        }
+      }
+    }
+
+    if (output.empty()) {
+      writeJson(std::cout, results);
+    } else {
+      bunsan::filesystem::ofstream fout(output);
+      BUNSAN_FILESYSTEM_FSTREAM_WRAP_BEGIN(fout) {
+        writeJson(fout, results);
+      } BUNSAN_FILESYSTEM_FSTREAM_WRAP_END(fout)
+      fout.close();
+    }
+  } catch (po::error &e) {
+    std::cerr << e.what() << std::endl
+              << desc << std::endl;
+    return 200;
+  } catch (std::exception &e) {
+    std::cerr << "Program terminated due to exception of type \""
+              << bunsan::runtime::type_name(e) << "\"." << std::endl;
+    std::cerr << "what() returns the following message:" << std::endl
+              << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -1,18 +1,72 @@
+#include <yandex/contest/invoker/flowctl/interactive/BrokerSocket.hpp>
 #include <yandex/contest/invoker/flowctl/interactive/SimpleBroker.hpp>
 
+#include <yandex/contest/StreamLog.hpp>
+
 #include <bunsan/runtime/demangle.hpp>
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/program_options.hpp>
 
+#include <cstdlib>
 #include <iostream>
 
+#include <unistd.h>
+
+namespace {
+constexpr const char *DAEMON_SOCKET_ENV = "SIMPLE_BROKER_DAEMON_SOCKET";
+
+using namespace yandex::contest::invoker::flowctl::interactive;
+
+void makeAbsolute(boost::optional<boost::filesystem::path> &path) {
+  if (path) path = boost::filesystem::absolute(*path);
+}
+
+/// \return status or none if daemon is not available
+boost::optional<SimpleBroker::Status> runOnDaemon(
+    const std::string &socketPath, SimpleBroker::Options options) {
+  // files are opened here, daemon uses paths in its messages only
+  makeAbsolute(options.dumpJudge);
+  makeAbsolute(options.dumpSolution);
+  makeAbsolute(options.statistics);
+
+  yandex::contest::system::unistd::Descriptor socket;
+  try {
+    socket = connectBrokerSocket(socketPath);
+    sendBrokerSession(socket.get(), options);
+  } catch (std::exception &e) {
+    STREAM_WARNING << "Unable to hand off session to " << socketPath << ": "
+                   << e.what() << ", running locally";
+    return boost::none;
+  }
+
+  // daemon owns session now, local copies would prevent EOF
+  for (const int fd : {options.notifierFd, options.interactorSourceFd,
+                       options.interactorSinkFd, options.solutionSourceFd,
+                       options.solutionSinkFd}) {
+    ::close(fd);
+  }
+  return receiveBrokerStatus(socket.get());
+}
+}  // namespace
+
 int main(int argc, char *argv[]) {
   using namespace yandex::contest::invoker::flowctl::interactive;
 
   SimpleBroker::Options options;
   std::uintmax_t terminationRealTimeLimitMillis;
+  std::uintmax_t busyPollMicros = 0;
+  int cpuAffinity;
 
-  std::string dumpJudge, dumpSolution;
+  std::string dumpJudge, dumpSolution, statistics;
+  std::string daemonSocket;
+  if (const char *const env = std::getenv(DAEMON_SOCKET_ENV))
+    daemonSocket = env;
+  AsyncDump::Options asyncDump;
+  std::uintmax_t asyncDumpMaxStallMillis = asyncDump.maxStall.count();
+  BufferRelay::CoalescingOptions coalescing;
+  std::string coalesceDelimiter;
+  std::uintmax_t coalesceDelayMicros = 50;
 
   namespace po = boost::program_options;
   po::options_description desc("Usage");
@@ -43,12 +97,70 @@ int main(int argc, char *argv[]) {
         "termination-real-time-limit-millis",
         po::value<std::uintmax_t>(&terminationRealTimeLimitMillis)->required(),
         "termination real time limit in milliseconds"
+    )(
+        "relay-mode", po::value<Relay::Mode>(&options.relayMode),
+        "relay mode: BUFFERED, SPLICE, URING, THREADED or VECTORED"
+    )(
+        "relay-buffer-size",
+        po::value<std::size_t>(&options.relayBufferSize),
+        "userspace relay buffer size in bytes"
+    )(
+        "max-relay-buffer-size",
+        po::value<std::size_t>(&options.maxRelayBufferSize),
+        "grow buffered relay's buffer up to this size "
+        "while reads keep filling it"
+    )(
+        "pipe-capacity", po::value<std::size_t>(&options.pipeCapacity),
+        "grow all four pipes to this capacity in bytes using F_SETPIPE_SZ"
     )(
         "dump-judge", po::value<std::string>(&dumpJudge),
         "dump judge->solution data"
     )(
         "dump-solution", po::value<std::string>(&dumpSolution),
         "dump solution->judge data"
+    )(
+        "async-dump", "write dumps from a separate thread"
+    )(
+        "async-dump-buffer-size",
+        po::value<std::size_t>(&asyncDump.bufferSize),
+        "asynchronous dump buffer size in bytes"
+    )(
+        "async-dump-overflow",
+        po::value<AsyncDump::OverflowPolicy>(&asyncDump.overflowPolicy),
+        "asynchronous dump overflow policy: BLOCK or TRUNCATE"
+    )(
+        "async-dump-max-stall-millis",
+        po::value<std::uintmax_t>(&asyncDumpMaxStallMillis),
+        "BLOCK policy truncates dump after waiting this long, "
+        "1000 ms by default"
+    )(
+        "statistics", po::value<std::string>(&statistics),
+        "write relay statistics in JSON on completion"
+    )(
+        "coalesce-interactor", "batch small writes of interactor"
+    )(
+        "coalesce-solution", "batch small writes of solution"
+    )(
+        "coalesce-threshold", po::value<std::size_t>(&coalescing.threshold),
+        "write batch as soon as this many bytes are pending"
+    )(
+        "coalesce-delimiter", po::value<std::string>(&coalesceDelimiter),
+        "write batch as soon as this character is read, \\n for newline"
+    )(
+        "coalesce-delay-micros",
+        po::value<std::uintmax_t>(&coalesceDelayMicros),
+        "maximum time data is held back, 50 us by default"
+    )(
+        "busy-poll-micros", po::value<std::uintmax_t>(&busyPollMicros),
+        "low latency profile: poll without blocking for this many "
+        "microseconds before waiting, costs CPU time while spinning"
+    )(
+        "cpu-affinity", po::value<int>(&cpuAffinity),
+        "pin broker to this CPU"
+    )(
+        "daemon-socket", po::value<std::string>(&daemonSocket),
+        "hand off session to simple_broker_daemon listening on this socket, "
+        "SIMPLE_BROKER_DAEMON_SOCKET environment variable by default"
     );
 
     po::variables_map vm;
@@ -58,6 +170,33 @@ int main(int argc, char *argv[]) {
         std::chrono::milliseconds(terminationRealTimeLimitMillis);
     if (vm.count("dump-judge")) options.dumpJudge = dumpJudge;
     if (vm.count("dump-solution")) options.dumpSolution = dumpSolution;
+    asyncDump.maxStall = std::chrono::milliseconds(asyncDumpMaxStallMillis);
+    if (vm.count("async-dump")) options.asyncDump = asyncDump;
+    if (vm.count("statistics")) options.statistics = statistics;
+    options.busyPollBudget = std::chrono::microseconds(busyPollMicros);
+
+    if (coalesceDelimiter == "\\n") coalesceDelimiter = "\n";
+    if (vm.count("coalesce-delimiter")) {
+      if (coalesceDelimiter.size() != 1)
+        throw po::invalid_option_value(coalesceDelimiter);
+      coalescing.delimiter = coalesceDelimiter[0];
+    }
+    coalescing.delay = std::chrono::microseconds(coalesceDelayMicros);
+    if (vm.count("coalesce-interactor"))
+      options.interactorCoalescing = coalescing;
+    if (vm.count("coalesce-solution")) options.solutionCoalescing = coalescing;
+    if (vm.count("cpu-affinity")) options.cpuAffinity = cpuAffinity;
+
+    // daemon shares execution loop between sessions
+    const bool ownLoop =
+        options.busyPollBudget.count() || options.cpuAffinity;
+    if (!daemonSocket.empty() && ownLoop) {
+      STREAM_INFO << "Latency profile requires own execution loop, "
+                  << "running locally";
+    } else if (!daemonSocket.empty()) {
+      if (const auto status = runOnDaemon(daemonSocket, options))
+        return static_cast<int>(*status);
+    }
 
     SimpleBroker broker(options);
     return static_cast<int>(broker.run());
@@ -0,0 +1,165 @@
+#include <yandex/contest/invoker/flowctl/interactive/BrokerPool.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/BrokerSocket.hpp>
+
+#include <yandex/contest/StreamLog.hpp>
+
+#include <bunsan/runtime/demangle.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <grp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+namespace {
+using namespace yandex::contest::invoker::flowctl::interactive;
+using yandex::contest::system::unistd::Descriptor;
+
+/// Receives requests on its own threads, slow client never blocks accept.
+class Receiver : private boost::noncopyable {
+ public:
+  explicit Receiver(const std::size_t threads)
+      : work_(new boost::asio::io_service::work(ioService_)) {
+    for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i)
+      threads_.emplace_back([this] { ioService_.run(); });
+  }
+
+  ~Receiver() {
+    work_.reset();
+    ioService_.stop();
+    for (std::thread &thread : threads_) thread.join();
+  }
+
+  template <typename Handler>
+  void post(Handler handler) {
+    ioService_.post(handler);
+  }
+
+ private:
+  boost::asio::io_service ioService_;
+  std::unique_ptr<boost::asio::io_service::work> work_;
+  std::vector<std::thread> threads_;
+};
+
+void logSessionError(const std::exception_ptr error) {
+  try {
+    std::rethrow_exception(error);
+  } catch (std::exception &e) {
+    STREAM_ERROR << "Session has failed: " << e.what();
+  } catch (...) {
+    STREAM_ERROR << "Session has failed with unknown exception";
+  }
+}
+
+void receive(BrokerPool &pool, const BrokerSocketAccess &access,
+             const std::shared_ptr<Descriptor> &client) {
+  SimpleBroker::Options options;
+  try {
+    checkBrokerPeer(client->get(), access);
+    options = receiveBrokerSession(client->get());
+  } catch (std::exception &e) {
+    STREAM_ERROR << "Unable to receive session: " << e.what();
+    return;
+  }
+
+  pool.submit(options, [client](const std::exception_ptr error,
+                                const SimpleBroker::Status status) {
+    if (error) logSessionError(error);
+    try {
+      sendBrokerStatus(client->get(), status);
+    } catch (std::exception &e) {
+      STREAM_ERROR << "Unable to send session status: " << e.what();
+    }
+  });
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::string socketPath;
+  std::string socketGroup;
+  BrokerPool::Options poolOptions;
+  std::uintmax_t receiveTimeoutMillis = 1000;
+  std::size_t receiveThreads = 4;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Usage");
+  try {
+    desc.add_options()(
+        "socket", po::value<std::string>(&socketPath)->required(),
+        "unix domain socket path"
+    )(
+        "workers", po::value<std::size_t>(&poolOptions.workers),
+        "number of worker threads, hardware concurrency by default"
+    )(
+        "sessions-per-worker",
+        po::value<std::size_t>(&poolOptions.sessionsPerWorker),
+        "maximum number of simultaneous sessions per worker"
+    )(
+        "receive-timeout-millis",
+        po::value<std::uintmax_t>(&receiveTimeoutMillis),
+        "session request receive timeout in milliseconds"
+    )(
+        "receive-threads", po::value<std::size_t>(&receiveThreads),
+        "number of threads receiving session requests"
+    )(
+        "socket-group", po::value<std::string>(&socketGroup),
+        "allow members of this group to connect, "
+        "only daemon's user and root are allowed by default"
+    );
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    po::notify(vm);
+
+    BrokerSocketAccess access;
+    if (vm.count("socket-group")) {
+      const group *const entry = ::getgrnam(socketGroup.c_str());
+      if (!entry) throw po::invalid_option_value(socketGroup);
+      access.group = entry->gr_gid;
+    }
+
+    BrokerPool pool(poolOptions);
+    const Descriptor listener = listenBrokerSocket(socketPath, access);
+    STREAM_INFO << "Listening on " << socketPath;
+    Receiver receiver(receiveThreads);
+
+    timeval receiveTimeout;
+    receiveTimeout.tv_sec = receiveTimeoutMillis / 1000;
+    receiveTimeout.tv_usec = receiveTimeoutMillis % 1000 * 1000;
+
+    for (;;) {
+      const int fd = ::accept4(listener.get(), nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd < 0) {
+        if (errno != EINTR)
+          STREAM_ERROR << "Unable to accept connection: "
+                       << std::strerror(errno);
+        continue;
+      }
+      const auto client = std::make_shared<Descriptor>(fd);
+      ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout,
+                   sizeof(receiveTimeout));
+      receiver.post(
+          [&pool, &access, client] { receive(pool, access, client); });
+    }
+  } catch (po::error &e) {
+    std::cerr << e.what() << std::endl
+              << desc << std::endl;
+    return 200;
+  } catch (std::exception &e) {
+    std::cerr << "Program terminated due to exception of type \""
+              << bunsan::runtime::type_name(e) << "\"." << std::endl;
+    std::cerr << "what() returns the following message:" << std::endl
+              << e.what() << std::endl;
+    return 1;
+  }
+}
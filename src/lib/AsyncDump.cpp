@@ -0,0 +1,178 @@
+#include <yandex/contest/invoker/flowctl/interactive/AsyncDump.hpp>
+
+#include "RelayUtility.hpp"
+
+#include <yandex/contest/StreamLog.hpp>
+#include <yandex/contest/SystemError.hpp>
+
+#include <cstring>
+
+#include <unistd.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+constexpr const char *AsyncDump::TRUNCATION_MARKER;
+
+AsyncDump::AsyncDump(const boost::filesystem::path &path,
+                     const Options &options)
+    : AsyncDump(openOutputFile(path), options) {}
+
+AsyncDump::AsyncDump(system::unistd::Descriptor file, const Options &options)
+    : options_(options), file_(std::move(file)), buffer_(options.bufferSize) {
+  thread_ = std::thread(&AsyncDump::run, this);
+}
+
+AsyncDump::~AsyncDump() { close(); }
+
+void AsyncDump::write(const char *data, std::size_t size) {
+  if (truncated_) return;
+
+  while (size) {
+    const std::size_t pushed = buffer_.push(data, size);
+    data += pushed;
+    size -= pushed;
+    notifyWriter();
+    if (!size) break;
+
+    if (options_.overflowPolicy == OverflowPolicy::TRUNCATE) {
+      STREAM_WARNING << "Dump buffer is full, truncating dump";
+      truncated_ = true;
+      return;
+    }
+
+    const auto begin = std::chrono::steady_clock::now();
+    bool ready;
+    {
+      std::unique_lock<std::mutex> lk(lock_);
+      producerWaiting_.store(true);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      ready = spaceReady_.wait_for(lk, options_.maxStall,
+                                   [this] { return !buffer_.full(); });
+      producerWaiting_.store(false);
+    }
+    stallTime_ += std::chrono::steady_clock::now() - begin;
+
+    if (!ready) {
+      STREAM_WARNING << "Dump writer has stalled for "
+                     << options_.maxStall.count() << " ms, truncating dump";
+      truncated_ = true;
+      return;
+    }
+  }
+}
+
+void AsyncDump::close() {
+  if (!thread_.joinable()) return;
+
+  closed_.store(true);
+  {
+    std::lock_guard<std::mutex> lk(lock_);
+    dataReady_.notify_one();
+  }
+  thread_.join();
+
+  statistics_.stallTime = stallTime_;
+  statistics_.truncated = truncated_;
+}
+
+void AsyncDump::notifyWriter() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (writerWaiting_.load()) {
+    std::lock_guard<std::mutex> lk(lock_);
+    dataReady_.notify_one();
+  }
+}
+
+void AsyncDump::notifyProducer() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (producerWaiting_.load()) {
+    std::lock_guard<std::mutex> lk(lock_);
+    spaceReady_.notify_one();
+  }
+}
+
+void AsyncDump::run() {
+  for (;;) {
+    if (buffer_.empty()) {
+      std::unique_lock<std::mutex> lk(lock_);
+      writerWaiting_.store(true);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      dataReady_.wait(lk, [this] { return !buffer_.empty() || closed_; });
+      writerWaiting_.store(false);
+      if (buffer_.empty()) break;
+    }
+    flush();
+  }
+
+  // producer has finished, truncated_ is safe to read
+  if (truncated_ && !statistics_.failed) {
+    const std::size_t size = std::strlen(TRUNCATION_MARKER);
+    if (::write(file_.get(), TRUNCATION_MARKER, size) !=
+        static_cast<ssize_t>(size)) {
+      statistics_.failed = true;
+    }
+  }
+  file_.close();
+}
+
+void AsyncDump::flush() {
+  iovec parts[2];
+  const int count = buffer_.readable(parts);
+  const std::size_t size =
+      parts[0].iov_len + (count > 1 ? parts[1].iov_len : 0);
+
+  if (statistics_.failed) {
+    // keep draining, producer must not block on a broken dump
+    buffer_.consume(size);
+    notifyProducer();
+    return;
+  }
+
+  const auto begin = std::chrono::steady_clock::now();
+  const ssize_t written = ::writev(file_.get(), parts, count);
+  statistics_.writeTime += std::chrono::steady_clock::now() - begin;
+  ++statistics_.writes;
+
+  if (written < 0) {
+    if (errno == EINTR) return;
+    STREAM_ERROR << "Unable to write dump: "
+                 << boost::system::error_code(errno,
+                                              boost::system::system_category())
+                        .message();
+    statistics_.failed = true;
+    return;
+  }
+
+  statistics_.bytes += written;
+  buffer_.consume(written);
+  notifyProducer();
+}
+
+std::ostream &operator<<(std::ostream &out,
+                         const AsyncDump::Statistics &statistics) {
+  using Seconds = std::chrono::duration<double>;
+  const double writeSeconds = Seconds(statistics.writeTime).count();
+  out << statistics.bytes << " bytes in " << statistics.writes << " writes, "
+      << writeSeconds << " s";
+  if (writeSeconds > 0)
+    out << " (" << statistics.bytes / writeSeconds / (1024 * 1024)
+        << " MiB/s)";
+  out << ", stalled for "
+      << std::chrono::duration_cast<std::chrono::milliseconds>(
+             statistics.stallTime)
+             .count()
+      << " ms";
+  if (statistics.truncated) out << ", truncated";
+  if (statistics.failed) out << ", failed";
+  return out;
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
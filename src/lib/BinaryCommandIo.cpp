@@ -0,0 +1,122 @@
+#include <yandex/contest/invoker/flowctl/interactive/BinaryCommandIo.hpp>
+
+#include <limits>
+
+#include <cstring>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+static_assert(CommandSet::CAPACITY < 0x100, "Command code is a single byte");
+
+std::size_t encodeVarintTo(std::uint64_t value, char *const out) {
+  std::size_t size = 0;
+  while (value >= 0x80) {
+    out[size++] = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  out[size++] = static_cast<char>(value);
+  return size;
+}
+
+std::size_t decodeVarint(const StringRef data, std::uint64_t &value,
+                         boost::system::error_code &ec) {
+  ec.clear();
+  value = 0;
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    const unsigned char byte = data[i];
+    // the last byte holds the single remaining bit
+    if (i == MAX_VARINT_SIZE - 1 && byte > 1) {
+      ec = CommandIoErrc::INVALID_LENGTH;
+      return i;
+    }
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << (7 * i);
+    if (!(byte & 0x80)) return i + 1;
+  }
+  ec = CommandIoErrc::INSUFFICIENT_DATA;
+  return data.size();
+}
+
+std::size_t maxEncodedBinaryCommandPackSize(const CommandSet &set) {
+  std::size_t size = 2;
+  for (const CommandName name : set)
+    size += 1 + MAX_VARINT_SIZE + set.value(name).size();
+  return size;
+}
+
+std::size_t encodeBinaryCommandPackTo(const CommandSet &set, char *const out) {
+  std::size_t size = 0;
+  out[size++] = BINARY_COMMAND_PACK_MAGIC;
+  for (const CommandName name : set) {
+    const std::string &value = set.value(name);
+    out[size++] = static_cast<char>(1 + CommandSet::index(name));
+    size += encodeVarintTo(value.size(), out + size);
+    std::memcpy(out + size, value.data(), value.size());
+    size += value.size();
+  }
+  out[size++] = BINARY_COMMAND_PACK_END;
+  return size;
+}
+
+void appendEncodedBinaryCommandPack(const CommandSet &set, std::string &out) {
+  const std::size_t size = out.size();
+  out.resize(size + maxEncodedBinaryCommandPackSize(set));
+  out.resize(size + encodeBinaryCommandPackTo(set, &out[size]));
+}
+
+std::size_t decodeBinaryCommandPackTo(const StringRef data, CommandSet &set,
+                                      boost::system::error_code &ec) {
+  ec.clear();
+  set.clear();
+  if (data.empty()) {
+    ec = CommandIoErrc::INSUFFICIENT_DATA;
+    return 1;
+  }
+  if (data[0] != BINARY_COMMAND_PACK_MAGIC) {
+    ec = CommandIoErrc::CHARACTER_IS_NOT_PERMITTED;
+    return 0;
+  }
+  std::size_t pos = 1;
+  while (pos < data.size()) {
+    const std::size_t code = static_cast<unsigned char>(data[pos]);
+    if (data[pos] == BINARY_COMMAND_PACK_END) return pos + 1;
+    if (code > CommandSet::CAPACITY) {
+      ec = CommandIoErrc::UNKNOWN_COMMAND_NAME;
+      return pos;
+    }
+    const CommandName name = CommandSet::name(code - 1);
+
+    std::uint64_t size;
+    const std::size_t begin =
+        pos + 1 + decodeVarint(data.substr(pos + 1), size, ec);
+    if (ec == CommandIoErrc::INSUFFICIENT_DATA) return data.size() + 1;
+    if (ec) return begin;
+    if (size > data.size() - begin) {
+      ec = CommandIoErrc::INSUFFICIENT_DATA;
+      // value and the next code byte
+      const std::size_t max = std::numeric_limits<std::size_t>::max();
+      return size < max - begin ? begin + size + 1 : max;
+    }
+
+    if (isParameter(name)) {
+      set.parameter(name).assign(data.data() + begin, size);
+    } else if (size) {
+      ec = CommandIoErrc::UNEXPECTED_VALUE;
+      return begin;
+    } else {
+      set.insert(name);
+    }
+    pos = begin + size;
+  }
+  ec = CommandIoErrc::INSUFFICIENT_DATA;
+  return pos + 1;
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
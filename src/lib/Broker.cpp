@@ -1,16 +1,391 @@
 #include <yandex/contest/invoker/flowctl/interactive/Broker.hpp>
 
+#include <yandex/contest/invoker/flowctl/interactive/BinaryCommandIo.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/CommandPackDecoder.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/Error.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/FrameReader.hpp>
+
+#include <yandex/contest/StreamLog.hpp>
+
+#include <boost/asio/detail/signal_init.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+
 namespace yandex {
 namespace contest {
 namespace invoker {
 namespace flowctl {
 namespace interactive {
 
-Broker::Broker(const Options &options) : options_(options) {}
+namespace {
+class Router : private boost::noncopyable {
+ public:
+  using Connection = FrameReader::Connection;
+  using Status = Broker::Status;
+
+ public:
+  Router(boost::asio::io_service &ioService, const Broker::Options &options)
+      : options_(options),
+        interactorSource_(ioService, options.interactorBrokerFd),
+        interactorSink_(ioService, options.brokerInteractorFd),
+        solutionSource_(ioService, options.solutionBrokerFd),
+        solutionSink_(ioService, options.brokerSolutionFd),
+        requests_(interactorSource_, options.requestDelimiter),
+        responses_(solutionSource_, options.responseDelimiter),
+        commands_([this](const CommandName name, const std::string &value) {
+          handle_command(name, value);
+        }) {}
+
+  void start() {
+    if (options_.emptyFirstRequest)
+      pending_.push_back(options_.responseMultiplier);
+    if (options_.binaryCommands)
+      negotiate();
+    else
+      readRequest();
+    readResponses();
+  }
+
+  boost::optional<Status> status() const { return status_; }
+
+ private:
+  /// First byte of the first request selects command format.
+  void negotiate() {
+    requests_.async_peek(1, [this](const boost::system::error_code &ec,
+                                   const char *const data,
+                                   const std::size_t size) {
+      if (status_) return;
+      if (ec && ec != boost::asio::error::eof) {
+        STREAM_ERROR << "Interactor read failure: " << ec.message();
+        finish(Broker::FAILED);
+        return;
+      }
+      if (!size) {
+        handle_interactor_eof();
+        return;
+      }
+      binary_ = isBinaryCommandPack(StringRef(data, size));
+      STREAM_INFO << "Interactor uses " << (binary_ ? "binary" : "text")
+                  << " command format";
+      readRequest();
+    });
+  }
+
+  void readRequest() {
+    if (binary_) {
+      readBinaryRequest(1);
+      return;
+    }
+    requests_.async_read_frame([this](const boost::system::error_code &ec,
+                                      const char *const data,
+                                      const std::size_t size) {
+      if (status_) return;
+      if (ec) {
+        if (ec != boost::asio::error::eof) {
+          STREAM_ERROR << "Interactor read failure: " << ec.message();
+          finish(Broker::FAILED);
+        } else if (size) {
+          finish(Broker::INTERACTOR_INSUFFICIENT_DATA);
+        } else {
+          handle_interactor_eof();
+        }
+        return;
+      }
+      forwardRequest(data, size);
+    });
+  }
+
+  void forwardRequest(const char *data, std::size_t size) {
+    std::size_t multiplier = options_.responseMultiplier;
+    if (options_.requestCommands) {
+      try {
+        commands_.reset();
+        responseMultiplier_ = boost::none;
+        const std::size_t packSize = commands_.feed(data, size);
+        if (!commands_.complete())
+          BOOST_THROW_EXCEPTION(DecodeCommandPackError()
+                                << DecodeCommandPackError::message(
+                                       "Command pack is not terminated"));
+        if (responseMultiplier_) multiplier = *responseMultiplier_;
+        data += packSize;
+        size -= packSize;
+      } catch (std::exception &e) {
+        STREAM_ERROR << "Invalid request command pack: " << e.what();
+        finish(Broker::INTERACTOR_INVALID_COMMAND);
+        return;
+      }
+    }
+
+    ++requestsCount_;
+    pending_.push_back(multiplier);
+    if (!readingResponses_) readResponses();
+
+    boost::asio::async_write(
+        solutionSink_, boost::asio::buffer(data, size),
+        [this](const boost::system::error_code &ec, const std::size_t) {
+          if (status_) return;
+          if (ec) {
+            STREAM_ERROR << "Solution write failure: " << ec.message();
+            finish(Broker::FAILED);
+            return;
+          }
+          readRequest();
+        });
+  }
+
+  /// Wait until command pack and payload length are buffered.
+  void readBinaryRequest(const std::size_t minSize) {
+    requests_.async_peek(minSize, [this](const boost::system::error_code &ec,
+                                         const char *const data,
+                                         const std::size_t size) {
+      if (status_) return;
+      if (ec && ec != boost::asio::error::eof) {
+        STREAM_ERROR << "Interactor read failure: " << ec.message();
+        finish(Broker::FAILED);
+        return;
+      }
+      if (ec && !size) {
+        handle_interactor_eof();
+        return;
+      }
+
+      // header is decoded only when the missing part has arrived
+      boost::system::error_code decodeEc;
+      std::size_t headerSize = decodeBinaryCommandPackTo(
+          StringRef(data, size), binaryCommands_, decodeEc);
+      std::uint64_t payloadSize = 0;
+      if (!decodeEc) {
+        headerSize +=
+            decodeVarint(StringRef(data + headerSize, size - headerSize),
+                         payloadSize, decodeEc);
+        if (decodeEc == CommandIoErrc::INSUFFICIENT_DATA)
+          headerSize = size + 1;
+      }
+      if (decodeEc == CommandIoErrc::INSUFFICIENT_DATA && ec) {
+        finish(Broker::INTERACTOR_INSUFFICIENT_DATA);
+        return;
+      }
+      if (headerSize > options_.maxHeaderSize) {
+        STREAM_ERROR << "Request header exceeds " << options_.maxHeaderSize
+                     << " bytes";
+        finish(Broker::INTERACTOR_INVALID_COMMAND);
+        return;
+      }
+      if (decodeEc == CommandIoErrc::INSUFFICIENT_DATA) {
+        readBinaryRequest(headerSize);
+        return;
+      }
+      if (decodeEc) {
+        STREAM_ERROR << "Invalid request command pack: "
+                     << decodeEc.message();
+        finish(Broker::INTERACTOR_INVALID_COMMAND);
+        return;
+      }
+
+      std::size_t multiplier = options_.responseMultiplier;
+      if (binaryCommands_.contains(RESPONSE_MULTIPLIER)) {
+        try {
+          multiplier = boost::lexical_cast<std::size_t>(
+              binaryCommands_.value(RESPONSE_MULTIPLIER));
+        } catch (std::exception &e) {
+          STREAM_ERROR << "Invalid request command pack: " << e.what();
+          finish(Broker::INTERACTOR_INVALID_COMMAND);
+          return;
+        }
+      }
+
+      ++requestsCount_;
+      pending_.push_back(multiplier);
+      if (!readingResponses_) readResponses();
+      forwardPayload(headerSize, payloadSize);
+    });
+  }
+
+  /*!
+   * Forward payload to solution chunk by chunk as it arrives,
+   * skip bytes of already decoded header first.
+   */
+  void forwardPayload(const std::size_t skip, const std::uint64_t remaining) {
+    const std::uint64_t limit = skip + remaining;
+    requests_.async_read_chunk(
+        static_cast<std::size_t>(std::min<std::uint64_t>(
+            limit, std::numeric_limits<std::size_t>::max())),
+        [this, skip, remaining](const boost::system::error_code &ec,
+                                const char *const data,
+                                const std::size_t size) {
+          if (status_) return;
+          if (ec) {
+            if (ec != boost::asio::error::eof) {
+              STREAM_ERROR << "Interactor read failure: " << ec.message();
+              finish(Broker::FAILED);
+            } else {
+              finish(Broker::INTERACTOR_INSUFFICIENT_DATA);
+            }
+            return;
+          }
+          const std::size_t skipped = std::min(skip, size);
+          const std::size_t chunk = size - skipped;
+          const std::uint64_t left = remaining - chunk;
+          if (!chunk) {
+            continuePayload(skip - skipped, left);
+            return;
+          }
+          boost::asio::async_write(
+              solutionSink_, boost::asio::buffer(data + skipped, chunk),
+              [this, left](const boost::system::error_code &ec,
+                           const std::size_t) {
+                if (status_) return;
+                if (ec) {
+                  STREAM_ERROR << "Solution write failure: " << ec.message();
+                  finish(Broker::FAILED);
+                  return;
+                }
+                continuePayload(0, left);
+              });
+        });
+  }
+
+  void continuePayload(const std::size_t skip, const std::uint64_t remaining) {
+    if (skip || remaining)
+      forwardPayload(skip, remaining);
+    else
+      readRequest();
+  }
+
+  void handle_command(const CommandName name, const std::string &value) {
+    if (name == CommandName::RESPONSE_MULTIPLIER)
+      responseMultiplier_ = boost::lexical_cast<std::size_t>(value);
+  }
+
+  /// Interactor has finished, solution will not get more requests.
+  void handle_interactor_eof() {
+    STREAM_INFO << "Interactor has finished after " << requestsCount_
+                << " requests, closing solution's STDIN";
+    interactorEof_ = true;
+    boost::system::error_code ec;
+    solutionSink_.close(ec);
+    if (!readingResponses_) readResponses();
+  }
+
+  void readResponses() {
+    while (!pending_.empty() && !pending_.front()) pending_.pop_front();
+    if (pending_.empty()) {
+      readingResponses_ = false;
+      if (interactorEof_) drainSolution();
+      return;
+    }
+    readingResponses_ = true;
+
+    responses_.async_read_frames(
+        pending_.front(),
+        [this](const boost::system::error_code &ec, const char *const data,
+               const std::size_t size) {
+          if (status_) return;
+          if (ec) {
+            if (ec != boost::asio::error::eof) {
+              STREAM_ERROR << "Solution read failure: " << ec.message();
+              finish(Broker::FAILED);
+            } else {
+              finish(Broker::SOLUTION_INSUFFICIENT_DATA);
+            }
+            return;
+          }
+          pending_.pop_front();
+          boost::asio::async_write(
+              interactorSink_, boost::asio::buffer(data, size),
+              [this](const boost::system::error_code &ec, const std::size_t) {
+                if (status_) return;
+                if (ec) {
+                  STREAM_ERROR << "Interactor write failure: "
+                               << ec.message();
+                  finish(Broker::FAILED);
+                  return;
+                }
+                readResponses();
+              });
+        });
+  }
+
+  /// All responses are forwarded, solution must not write anything else.
+  void drainSolution() {
+    readingResponses_ = true;
+    responses_.async_read_frame([this](const boost::system::error_code &ec,
+                                       const char *, const std::size_t size) {
+      if (status_) return;
+      if (ec && ec != boost::asio::error::eof) {
+        STREAM_ERROR << "Solution read failure: " << ec.message();
+        finish(Broker::FAILED);
+      } else if (size) {
+        finish(Broker::SOLUTION_EXCESS_DATA);
+      } else {
+        finish(Broker::OK);
+      }
+    });
+  }
+
+  void finish(const Status status) {
+    status_ = status;
+    STREAM_INFO << "Broker status = " << status;
+
+    boost::system::error_code ec;
+    interactorSource_.close(ec);
+    interactorSink_.close(ec);
+    solutionSource_.close(ec);
+    solutionSink_.close(ec);
+  }
+
+ private:
+  const Broker::Options options_;
+
+  Connection interactorSource_;
+  Connection interactorSink_;
+  Connection solutionSource_;
+  Connection solutionSink_;
+
+  FrameReader requests_;
+  FrameReader responses_;
+
+  /// Commands of the current request.
+  CommandPackDecoder commands_;
+  boost::optional<std::size_t> responseMultiplier_;
+
+  /// Binary command format has been negotiated.
+  bool binary_ = false;
+  CommandSet binaryCommands_;
+
+  /// Number of responses expected for each forwarded request.
+  std::deque<std::size_t> pending_;
+  bool readingResponses_ = false;
+  bool interactorEof_ = false;
+
+  std::size_t requestsCount_ = 0;
+  boost::optional<Status> status_;
+};
+}  // namespace
+
+Broker::Broker(const Options &options) : options_(options) {
+  if (options_.requestDelimiter.empty() || options_.responseDelimiter.empty())
+    BOOST_THROW_EXCEPTION(BrokerEmptyDelimiterError());
+}
 
 Broker::Status Broker::run() {
-  // TODO
-  return OK;
+  boost::asio::detail::signal_init<SIGPIPE> sigpipe_init;
+  boost::asio::io_service ioService;
+
+  Router router(ioService, options_);
+  router.start();
+
+  STREAM_INFO << "Starting execution loop";
+  ioService.run();
+  STREAM_INFO << "Execution loop has finished";
+
+  // Router always finishes before execution loop has finished.
+  BOOST_ASSERT(router.status());
+
+  return *router.status();
 }
 
 }  // namespace interactive
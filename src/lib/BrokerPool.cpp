@@ -0,0 +1,197 @@
+#include <yandex/contest/invoker/flowctl/interactive/BrokerPool.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/SimpleBrokerSession.hpp>
+
+#include <yandex/contest/StreamLog.hpp>
+
+#include <algorithm>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+BrokerPool::BrokerPool() : BrokerPool(Options()) {}
+
+BrokerPool::BrokerPool(const Options &options)
+    : sessionsPerWorker_(std::max<std::size_t>(options.sessionsPerWorker, 1)) {
+  std::size_t workers = options.workers;
+  if (!workers) workers = std::max(std::thread::hardware_concurrency(), 1u);
+
+  for (std::size_t i = 0; i < workers; ++i) {
+    workers_.emplace_back(new Worker);
+    Worker &worker = *workers_.back();
+    worker.work.reset(new boost::asio::io_service::work(worker.ioService));
+    worker.thread = std::thread([this, &worker] { run(worker); });
+  }
+}
+
+BrokerPool::~BrokerPool() {
+  wait();
+  for (const auto &worker : workers_) worker->work.reset();
+  for (const auto &worker : workers_) worker->thread.join();
+}
+
+void BrokerPool::run(Worker &worker) {
+  for (;;) {
+    try {
+      worker.ioService.run();
+      break;
+    } catch (...) {
+      fail(worker, std::current_exception());
+    }
+  }
+}
+
+void BrokerPool::fail(Worker &worker, const std::exception_ptr error) {
+  try {
+    std::rethrow_exception(error);
+  } catch (std::exception &e) {
+    STREAM_ERROR << "Session handler has thrown: " << e.what();
+  } catch (...) {
+    STREAM_ERROR << "Session handler has thrown unknown exception";
+  }
+
+  // sessions remove themselves on completion
+  const std::vector<std::weak_ptr<SimpleBrokerSession>> sessions =
+      worker.sessions;
+  if (sessions.size() > 1)
+    STREAM_ERROR << "Failing all " << sessions.size()
+                 << " sessions of the worker";
+  for (const auto &weakSession : sessions) {
+    if (const auto session = weakSession.lock()) session->fail(error);
+  }
+}
+
+void BrokerPool::submit(const SimpleBroker::Options &options,
+                        const Handler &handler) {
+  {
+    const std::lock_guard<std::mutex> lk(lock_);
+    ++sessions_;
+  }
+
+  Worker &worker = *workers_[next_++ % workers_.size()];
+  {
+    const std::lock_guard<std::mutex> lk(worker.lock);
+    worker.pending.push_back(Session{options, handler});
+  }
+  worker.ioService.post([this, &worker] { schedule(worker); });
+
+  // let idle worker steal the session if owner is busy
+  if (worker.active < sessionsPerWorker_) return;
+  for (const auto &idle : workers_) {
+    if (idle->active < sessionsPerWorker_) {
+      Worker &thief = *idle;
+      thief.ioService.post([this, &thief] { schedule(thief); });
+      break;
+    }
+  }
+}
+
+std::future<BrokerPool::Status> BrokerPool::submit(
+    const SimpleBroker::Options &options) {
+  const auto promise = std::make_shared<std::promise<Status>>();
+  submit(options, [promise](std::exception_ptr error, const Status status) {
+    if (error)
+      promise->set_exception(error);
+    else
+      promise->set_value(status);
+  });
+  return promise->get_future();
+}
+
+void BrokerPool::wait() {
+  std::unique_lock<std::mutex> lk(lock_);
+  completed_.wait(lk, [this] { return !sessions_; });
+}
+
+void BrokerPool::schedule(Worker &worker) {
+  Session session;
+  while (worker.active < sessionsPerWorker_ &&
+         (pop(worker, session) || steal(worker, session))) {
+    start(worker, session);
+  }
+}
+
+bool BrokerPool::pop(Worker &worker, Session &session) {
+  const std::lock_guard<std::mutex> lk(worker.lock);
+  if (worker.pending.empty()) return false;
+  session = std::move(worker.pending.front());
+  worker.pending.pop_front();
+  return true;
+}
+
+bool BrokerPool::steal(Worker &thief, Session &session) {
+  const auto self = std::find_if(
+      workers_.begin(), workers_.end(),
+      [&thief](const std::unique_ptr<Worker> &w) { return w.get() == &thief; });
+  const std::size_t index = self - workers_.begin();
+
+  for (std::size_t i = 1; i < workers_.size(); ++i) {
+    Worker &victim = *workers_[(index + i) % workers_.size()];
+    const std::lock_guard<std::mutex> lk(victim.lock);
+    if (victim.pending.empty()) continue;
+    session = std::move(victim.pending.back());
+    victim.pending.pop_back();
+    return true;
+  }
+  return false;
+}
+
+void BrokerPool::start(Worker &worker, Session &session) {
+  const Handler handler = std::move(session.handler);
+  ++worker.active;
+  try {
+    const auto brokerSession = std::make_shared<SimpleBrokerSession>(
+        worker.ioService, session.options);
+    const std::weak_ptr<SimpleBrokerSession> weakSession = brokerSession;
+    brokerSession->start([this, &worker, handler,
+                          weakSession](const Status status) {
+      std::exception_ptr error;
+      if (const auto brokerSession = weakSession.lock())
+        error = brokerSession->error();
+      forget(worker, weakSession);
+      complete(worker, handler, error, status);
+      schedule(worker);
+    });
+    // handler is never called from start()
+    worker.sessions.push_back(weakSession);
+  } catch (std::exception &e) {
+    STREAM_ERROR << "Unable to start session: " << e.what();
+    complete(worker, handler, std::current_exception(), SimpleBroker::FAILED);
+  }
+}
+
+void BrokerPool::forget(Worker &worker,
+                        const std::weak_ptr<SimpleBrokerSession> &session) {
+  // destroyed sessions are dropped as well
+  auto &sessions = worker.sessions;
+  sessions.erase(
+      std::remove_if(sessions.begin(), sessions.end(),
+                     [&session](const std::weak_ptr<SimpleBrokerSession> &s) {
+                       return s.expired() || !(s.owner_before(session) ||
+                                               session.owner_before(s));
+                     }),
+      sessions.end());
+}
+
+void BrokerPool::complete(Worker &worker, const Handler &handler,
+                          std::exception_ptr error, const Status status) {
+  --worker.active;
+  try {
+    handler(error, status);
+  } catch (std::exception &e) {
+    STREAM_ERROR << "Session handler has failed: " << e.what();
+  }
+
+  const std::lock_guard<std::mutex> lk(lock_);
+  --sessions_;
+  if (!sessions_) completed_.notify_all();
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
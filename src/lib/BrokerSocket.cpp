@@ -0,0 +1,463 @@
+#include <yandex/contest/invoker/flowctl/interactive/BrokerSocket.hpp>
+
+#include "RelayUtility.hpp"
+
+#include <yandex/contest/invoker/flowctl/interactive/Error.hpp>
+
+#include <yandex/contest/SystemError.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <grp.h>
+#include <pwd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+constexpr std::uint8_t PROTOCOL_VERSION = 6;
+
+/// Session file descriptors followed by output files.
+constexpr std::size_t SESSION_FD_COUNT = 5;
+constexpr std::size_t MAX_FD_COUNT = SESSION_FD_COUNT + 3;
+constexpr std::size_t MAX_PAYLOAD_SIZE = 64 * 1024;
+
+sockaddr_un makeAddress(const boost::filesystem::path &path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  const std::string &name = path.string();
+  if (name.size() >= sizeof(address.sun_path))
+    BOOST_THROW_EXCEPTION(BrokerSocketError()
+                          << BrokerSocketError::message("Path is too long"));
+  std::memcpy(address.sun_path, name.c_str(), name.size());
+  return address;
+}
+
+system::unistd::Descriptor makeSocket() {
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) BOOST_THROW_EXCEPTION(SystemError("socket"));
+  return system::unistd::Descriptor(fd);
+}
+
+class PayloadWriter {
+ public:
+  template <typename T>
+  void put(const T value) {
+    data_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  void put(const boost::optional<boost::filesystem::path> &path) {
+    put<std::uint8_t>(path.is_initialized());
+    if (!path) return;
+    const std::string &name = path->string();
+    put<std::uint32_t>(name.size());
+    data_.append(name);
+  }
+
+  void put(const boost::optional<BufferRelay::CoalescingOptions> &options) {
+    put<std::uint8_t>(options.is_initialized());
+    if (!options) return;
+    put<std::uint64_t>(options->threshold);
+    put<std::uint8_t>(options->delimiter.is_initialized());
+    put<char>(options->delimiter.value_or('\0'));
+    put<std::int64_t>(options->delay.count());
+  }
+
+  const std::string &data() const { return data_; }
+
+ private:
+  std::string data_;
+};
+
+class PayloadReader {
+ public:
+  PayloadReader(const char *const data, const std::size_t size)
+      : data_(data), size_(size) {}
+
+  template <typename T>
+  T get() {
+    T value;
+    std::memcpy(&value, take(sizeof(value)), sizeof(value));
+    return value;
+  }
+
+  boost::optional<boost::filesystem::path> getPath() {
+    if (!get<std::uint8_t>()) return boost::none;
+    const std::size_t size = get<std::uint32_t>();
+    return boost::filesystem::path(std::string(take(size), size));
+  }
+
+  boost::optional<BufferRelay::CoalescingOptions> getCoalescing() {
+    if (!get<std::uint8_t>()) return boost::none;
+    BufferRelay::CoalescingOptions options;
+    options.threshold = get<std::uint64_t>();
+    const bool hasDelimiter = get<std::uint8_t>();
+    const char delimiter = get<char>();
+    if (hasDelimiter) options.delimiter = delimiter;
+    options.delay = std::chrono::microseconds(get<std::int64_t>());
+    return options;
+  }
+
+  bool empty() const { return !size_; }
+
+ private:
+  const char *take(const std::size_t size) {
+    if (size > size_)
+      BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                            << BrokerSocketProtocolError::message(
+                                   "Unexpected end of payload"));
+    const char *const data = data_;
+    data_ += size;
+    size_ -= size;
+    return data;
+  }
+
+  const char *data_;
+  std::size_t size_;
+};
+
+std::string encodeOptions(const SimpleBroker::Options &options) {
+  PayloadWriter writer;
+  writer.put<std::uint8_t>(PROTOCOL_VERSION);
+  writer.put<std::uint64_t>(options.outputLimitBytes);
+  writer.put<std::int64_t>(options.terminationRealTimeLimit.count());
+  writer.put<std::uint8_t>(static_cast<std::uint8_t>(options.relayMode));
+  writer.put<std::uint64_t>(options.relayBufferSize);
+  writer.put<std::uint64_t>(options.maxRelayBufferSize);
+  writer.put<std::uint64_t>(options.pipeCapacity);
+  writer.put(options.interactorCoalescing);
+  writer.put(options.solutionCoalescing);
+  writer.put(options.dumpJudge);
+  writer.put(options.dumpSolution);
+  writer.put<std::uint8_t>(options.asyncDump.is_initialized());
+  if (options.asyncDump) {
+    writer.put<std::uint64_t>(options.asyncDump->bufferSize);
+    writer.put<std::uint8_t>(
+        static_cast<std::uint8_t>(options.asyncDump->overflowPolicy));
+    writer.put<std::int64_t>(options.asyncDump->maxStall.count());
+  }
+  writer.put(options.statistics);
+  return writer.data();
+}
+
+void decodeOptions(const char *const data, const std::size_t size,
+                   SimpleBroker::Options &options) {
+  PayloadReader reader(data, size);
+  if (reader.get<std::uint8_t>() != PROTOCOL_VERSION)
+    BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                          << BrokerSocketProtocolError::message(
+                                 "Unsupported protocol version"));
+  options.outputLimitBytes = reader.get<std::uint64_t>();
+  options.terminationRealTimeLimit =
+      std::chrono::milliseconds(reader.get<std::int64_t>());
+
+  const std::uint8_t relayMode = reader.get<std::uint8_t>();
+  if (relayMode > static_cast<std::uint8_t>(Relay::Mode::VECTORED))
+    BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                          << BrokerSocketProtocolError::message(
+                                 "Invalid relay mode"));
+  options.relayMode = static_cast<Relay::Mode>(relayMode);
+  options.relayBufferSize = reader.get<std::uint64_t>();
+  options.maxRelayBufferSize = reader.get<std::uint64_t>();
+  options.pipeCapacity = reader.get<std::uint64_t>();
+  options.interactorCoalescing = reader.getCoalescing();
+  options.solutionCoalescing = reader.getCoalescing();
+
+  options.dumpJudge = reader.getPath();
+  options.dumpSolution = reader.getPath();
+  if (reader.get<std::uint8_t>()) {
+    AsyncDump::Options asyncDump;
+    asyncDump.bufferSize = reader.get<std::uint64_t>();
+    const std::uint8_t overflowPolicy = reader.get<std::uint8_t>();
+    if (overflowPolicy >
+        static_cast<std::uint8_t>(AsyncDump::OverflowPolicy::TRUNCATE))
+      BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                            << BrokerSocketProtocolError::message(
+                                   "Invalid overflow policy"));
+    asyncDump.overflowPolicy =
+        static_cast<AsyncDump::OverflowPolicy>(overflowPolicy);
+    asyncDump.maxStall = std::chrono::milliseconds(reader.get<std::int64_t>());
+    options.asyncDump = asyncDump;
+  }
+  options.statistics = reader.getPath();
+
+  if (!reader.empty())
+    BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                          << BrokerSocketProtocolError::message(
+                                 "Unexpected data after payload"));
+}
+
+/// Peer's supplementary groups are not available, user's ones are used.
+bool isGroupMember(const ucred &credentials, const gid_t group) {
+  if (credentials.gid == group) return true;
+
+  std::vector<char> buffer(16 * 1024);
+  passwd entry;
+  passwd *user = nullptr;
+  if (::getpwuid_r(credentials.uid, &entry, buffer.data(), buffer.size(),
+                   &user) != 0 ||
+      !user)
+    return false;
+
+  int count = 64;
+  std::vector<gid_t> groups(count);
+  if (::getgrouplist(user->pw_name, user->pw_gid, groups.data(), &count) <
+      0) {
+    groups.resize(count);
+    if (::getgrouplist(user->pw_name, user->pw_gid, groups.data(), &count) <
+        0)
+      return false;
+  }
+  groups.resize(count);
+  return std::find(groups.begin(), groups.end(), group) != groups.end();
+}
+
+void sendAll(const int socket, const void *const data,
+             const std::size_t size) {
+  const char *ptr = static_cast<const char *>(data);
+  std::size_t left = size;
+  while (left) {
+    const ssize_t sent = ::send(socket, ptr, left, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      BOOST_THROW_EXCEPTION(SystemError("send"));
+    }
+    ptr += sent;
+    left -= sent;
+  }
+}
+
+void receiveAll(const int socket, void *const data, const std::size_t size) {
+  char *ptr = static_cast<char *>(data);
+  std::size_t left = size;
+  while (left) {
+    const ssize_t received = ::recv(socket, ptr, left, 0);
+    if (received < 0) {
+      if (errno == EINTR) continue;
+      BOOST_THROW_EXCEPTION(SystemError("recv"));
+    }
+    if (!received)
+      BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                            << BrokerSocketProtocolError::message(
+                                   "Connection was closed by peer"));
+    ptr += received;
+    left -= received;
+  }
+}
+}  // namespace
+
+system::unistd::Descriptor connectBrokerSocket(
+    const boost::filesystem::path &path) {
+  system::unistd::Descriptor socket = makeSocket();
+  const sockaddr_un address = makeAddress(path);
+  if (::connect(socket.get(), reinterpret_cast<const sockaddr *>(&address),
+                sizeof(address)) < 0)
+    BOOST_THROW_EXCEPTION(SystemError("connect"));
+  return socket;
+}
+
+system::unistd::Descriptor listenBrokerSocket(
+    const boost::filesystem::path &path, const BrokerSocketAccess &access) {
+  system::unistd::Descriptor socket = makeSocket();
+  const sockaddr_un address = makeAddress(path);
+  ::unlink(address.sun_path);
+
+  // socket file is created by bind(), it is never accessible to others
+  const mode_t mask = ::umask(0177);
+  const int bound =
+      ::bind(socket.get(), reinterpret_cast<const sockaddr *>(&address),
+             sizeof(address));
+  ::umask(mask);
+  if (bound < 0) BOOST_THROW_EXCEPTION(SystemError("bind"));
+
+  if (access.group) {
+    if (::chown(address.sun_path, -1, *access.group) < 0)
+      BOOST_THROW_EXCEPTION(SystemError("chown"));
+    if (::chmod(address.sun_path, 0660) < 0)
+      BOOST_THROW_EXCEPTION(SystemError("chmod"));
+  }
+
+  if (::listen(socket.get(), SOMAXCONN) < 0)
+    BOOST_THROW_EXCEPTION(SystemError("listen"));
+  return socket;
+}
+
+void checkBrokerPeer(const int socket, const BrokerSocketAccess &access) {
+  ucred credentials;
+  socklen_t size = sizeof(credentials);
+  if (::getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &credentials, &size) < 0)
+    BOOST_THROW_EXCEPTION(SystemError("getsockopt"));
+  if (!credentials.uid || credentials.uid == ::geteuid()) return;
+  if (access.group && isGroupMember(credentials, *access.group)) return;
+  BOOST_THROW_EXCEPTION(BrokerSocketAccessError()
+                        << BrokerSocketAccessError::uid(credentials.uid)
+                        << BrokerSocketAccessError::message(
+                               "Peer is not permitted"));
+}
+
+void sendBrokerSession(const int socket,
+                       const SimpleBroker::Options &options) {
+  const std::string payload = encodeOptions(options);
+  const std::uint32_t size = payload.size();
+  std::vector<int> fds = {options.notifierFd, options.interactorSourceFd,
+                          options.interactorSinkFd, options.solutionSourceFd,
+                          options.solutionSinkFd};
+
+  // daemon writes into files opened with client's permissions
+  std::vector<system::unistd::Descriptor> files;
+  const auto addFile = [&fds, &files](
+      const boost::optional<boost::filesystem::path> &path, const int fd) {
+    if (!path) return;
+    if (fd < 0) {
+      files.push_back(openOutputFile(*path));
+      fds.push_back(files.back().get());
+    } else {
+      fds.push_back(fd);
+    }
+  };
+  addFile(options.dumpJudge, options.dumpJudgeFd);
+  addFile(options.dumpSolution, options.dumpSolutionFd);
+  addFile(options.statistics, options.statisticsFd);
+  const std::size_t fdsSize = fds.size() * sizeof(int);
+
+  iovec iov;
+  iov.iov_base = const_cast<std::uint32_t *>(&size);
+  iov.iov_len = sizeof(size);
+
+  alignas(cmsghdr) char control[CMSG_SPACE(MAX_FD_COUNT * sizeof(int))];
+  std::memset(control, 0, sizeof(control));
+
+  msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = CMSG_SPACE(fdsSize);
+
+  cmsghdr *const cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(fdsSize);
+  std::memcpy(CMSG_DATA(cmsg), fds.data(), fdsSize);
+
+  ssize_t sent;
+  do {
+    sent = ::sendmsg(socket, &message, MSG_NOSIGNAL);
+  } while (sent < 0 && errno == EINTR);
+  if (sent < 0) BOOST_THROW_EXCEPTION(SystemError("sendmsg"));
+  if (static_cast<std::size_t>(sent) < sizeof(size)) {
+    sendAll(socket, reinterpret_cast<const char *>(&size) + sent,
+            sizeof(size) - sent);
+  }
+  sendAll(socket, payload.data(), payload.size());
+}
+
+SimpleBroker::Options receiveBrokerSession(const int socket) {
+  std::uint32_t size;
+  iovec iov;
+  iov.iov_base = &size;
+  iov.iov_len = sizeof(size);
+
+  alignas(cmsghdr) char control[CMSG_SPACE(MAX_FD_COUNT * sizeof(int))];
+
+  msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  ssize_t received;
+  do {
+    received = ::recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+  } while (received < 0 && errno == EINTR);
+  if (received < 0) BOOST_THROW_EXCEPTION(SystemError("recvmsg"));
+
+  // take ownership before any validation
+  std::vector<system::unistd::Descriptor> fds;
+  for (cmsghdr *cmsg = CMSG_FIRSTHDR(&message); cmsg;
+       cmsg = CMSG_NXTHDR(&message, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+    const std::size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    for (std::size_t i = 0; i < count; ++i) {
+      int fd;
+      std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+      fds.emplace_back(fd);
+    }
+  }
+
+  if (!received)
+    BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                          << BrokerSocketProtocolError::message(
+                                 "Connection was closed by peer"));
+  if ((message.msg_flags & MSG_CTRUNC) || fds.size() < SESSION_FD_COUNT)
+    BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                          << BrokerSocketProtocolError::message(
+                                 "Invalid number of file descriptors"));
+  if (static_cast<std::size_t>(received) < sizeof(size)) {
+    receiveAll(socket, reinterpret_cast<char *>(&size) + received,
+               sizeof(size) - received);
+  }
+  if (size > MAX_PAYLOAD_SIZE)
+    BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                          << BrokerSocketProtocolError::message(
+                                 "Payload is too large"));
+
+  std::string payload(size, '\0');
+  receiveAll(socket, &payload[0], payload.size());
+
+  SimpleBroker::Options options;
+  decodeOptions(payload.data(), payload.size(), options);
+
+  const std::size_t fdCount = SESSION_FD_COUNT +
+                              options.dumpJudge.is_initialized() +
+                              options.dumpSolution.is_initialized() +
+                              options.statistics.is_initialized();
+  if (fds.size() != fdCount)
+    BOOST_THROW_EXCEPTION(BrokerSocketProtocolError()
+                          << BrokerSocketProtocolError::message(
+                                 "Invalid number of file descriptors"));
+
+  std::size_t next = SESSION_FD_COUNT;
+  if (options.dumpJudge) options.dumpJudgeFd = fds[next++].release();
+  if (options.dumpSolution) options.dumpSolutionFd = fds[next++].release();
+  if (options.statistics) options.statisticsFd = fds[next++].release();
+
+  options.notifierFd = fds[0].release();
+  options.interactorSourceFd = fds[1].release();
+  options.interactorSinkFd = fds[2].release();
+  options.solutionSourceFd = fds[3].release();
+  options.solutionSinkFd = fds[4].release();
+  return options;
+}
+
+void sendBrokerStatus(const int socket, const SimpleBroker::Status status) {
+  const std::int32_t value = static_cast<std::int32_t>(status);
+  sendAll(socket, &value, sizeof(value));
+}
+
+SimpleBroker::Status receiveBrokerStatus(const int socket) {
+  std::int32_t value;
+  receiveAll(socket, &value, sizeof(value));
+  return static_cast<SimpleBroker::Status>(value);
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,219 @@
+#include <yandex/contest/invoker/flowctl/interactive/BufferRelay.hpp>
+
+#include <yandex/contest/StreamLog.hpp>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+constexpr std::size_t BufferRelay::DEFAULT_BUFFER_SIZE;
+
+BufferRelay::BufferRelay(Connection &source, Connection &sink,
+                         const Handler &readHandler,
+                         const Handler &writeHandler,
+                         const std::size_t bufferSize)
+    : source_(source),
+      sink_(sink),
+      readHandler_(readHandler),
+      writeHandler_(writeHandler),
+      bufferSize_(std::max<std::size_t>(bufferSize, 1)),
+      maxBufferSize_(bufferSize_),
+      deadline_(source.get_io_service()) {}
+
+void BufferRelay::setMaxBufferSize(const std::size_t maxBufferSize) {
+  maxBufferSize_ = std::max(maxBufferSize, bufferSize_);
+}
+
+void BufferRelay::setCoalescing(const CoalescingOptions &options) {
+  if (options.delay.count() > 0)
+    coalescing_ = options;
+  else
+    coalescing_ = boost::none;
+}
+
+void BufferRelay::setCloseSinkOnEof(const bool closeSinkOnEof) {
+  closeSinkOnEof_ = closeSinkOnEof;
+}
+
+void BufferRelay::setDiscardOnSinkError(const bool discardOnSinkError) {
+  discardOnSinkError_ = discardOnSinkError;
+}
+
+void BufferRelay::start() { read(); }
+
+void BufferRelay::close() {
+  closing_ = true;
+  if (reading_) {
+    boost::system::error_code ec;
+    source_.cancel(ec);
+  } else {
+    sourceDone_ = true;
+    if (!filled_) finish();
+  }
+}
+
+void BufferRelay::terminate() { finish(); }
+
+void BufferRelay::read() {
+  if (finished_ || reading_ || sourceDone_ || filled_ == chunks_.size())
+    return;
+
+  Chunk &chunk = openChunk();
+  if (!chunk.size && chunk.data.size() != bufferSize_) {
+    // chunk is free, old data does not have to be copied
+    chunk.data.clear();
+    chunk.data.resize(bufferSize_);
+  }
+
+  reading_ = true;
+  source_.async_read_some(
+      boost::asio::buffer(chunk.data.data() + chunk.size,
+                          chunk.data.size() - chunk.size),
+      boost::bind(&BufferRelay::handle_read, this,
+                  boost::asio::placeholders::error,
+                  boost::asio::placeholders::bytes_transferred));
+}
+
+void BufferRelay::handle_read(const boost::system::error_code &ec,
+                              const std::size_t size) {
+  reading_ = false;
+  if (finished_) return;
+
+  const bool deadline = flushRequested_;
+  flushRequested_ = false;
+  const bool canceled =
+      ec == boost::asio::error::operation_aborted && (closing_ || deadline);
+  if (ec && (!canceled || closing_)) sourceDone_ = true;
+
+  Chunk &chunk = openChunk();
+  if (size) {
+    if (readDataHandler_)
+      readDataHandler_(chunk.data.data() + chunk.size, size);
+    if (size == chunk.data.size() && bufferSize_ < maxBufferSize_) {
+      bufferSize_ = std::min(bufferSize_ * 2, maxBufferSize_);
+      STREAM_INFO << "Relay buffer has grown to " << bufferSize_ << " bytes";
+    }
+    chunk.size += size;
+  }
+  if (chunk.size) {
+    if (sourceDone_ || deadline || !coalescing_ || coalesced(chunk, size)) {
+      flush();
+    } else if (!deadlineArmed_) {
+      deadlineArmed_ = true;
+      deadline_.expires_from_now(coalescing_->delay);
+      deadline_.async_wait(boost::bind(&BufferRelay::handle_deadline, this,
+                                       boost::asio::placeholders::error));
+    }
+  }
+
+  if (!canceled)
+    readHandler_(ec, size);
+  else if (size)
+    readHandler_(boost::system::error_code(), size);
+  if (finished_) return;
+
+  write();
+  read();
+  if (sourceDone_ && !filled_ && (closeSinkOnEof_ || closing_)) finish();
+}
+
+bool BufferRelay::coalesced(const Chunk &chunk, const std::size_t size) const {
+  if (chunk.size == chunk.data.size()) return true;
+  if (coalescing_->threshold && chunk.size >= coalescing_->threshold)
+    return true;
+  return coalescing_->delimiter &&
+         std::memchr(chunk.data.data() + chunk.size - size,
+                     *coalescing_->delimiter, size);
+}
+
+void BufferRelay::flush() {
+  ++filled_;
+  if (deadlineArmed_) {
+    deadlineArmed_ = false;
+    deadline_.cancel();
+  }
+}
+
+void BufferRelay::handle_deadline(const boost::system::error_code &ec) {
+  if (finished_ || ec == boost::asio::error::operation_aborted) return;
+  deadlineArmed_ = false;
+  if (!reading_ || !openChunk().size) return;
+
+  // read buffer is the pending chunk, so read has to be restarted
+  flushRequested_ = true;
+  boost::system::error_code cancelEc;
+  source_.cancel(cancelEc);
+}
+
+void BufferRelay::write() {
+  while (!writing_ && filled_) {
+    if (!sinkFailed_) {
+      Chunk &chunk = chunks_[written_];
+      writing_ = true;
+      boost::asio::async_write(
+          sink_, boost::asio::buffer(chunk.data.data(), chunk.size),
+          boost::bind(&BufferRelay::handle_write, this,
+                      boost::asio::placeholders::error,
+                      boost::asio::placeholders::bytes_transferred));
+      return;
+    }
+    chunks_[written_].size = 0;
+    written_ = (written_ + 1) % chunks_.size();
+    --filled_;
+  }
+}
+
+void BufferRelay::handle_write(const boost::system::error_code &ec,
+                               const std::size_t size) {
+  writing_ = false;
+  if (finished_) return;
+
+  if (size && writeDataHandler_)
+    writeDataHandler_(chunks_[written_].data.data(), size);
+  chunks_[written_].size = 0;
+  written_ = (written_ + 1) % chunks_.size();
+  --filled_;
+
+  if (ec) {
+    sinkFailed_ = true;
+    writeHandler_(ec, size);
+    if (finished_) return;
+    if (!discardOnSinkError_) {
+      finish();
+      return;
+    }
+  } else {
+    writeHandler_(ec, size);
+    if (finished_) return;
+  }
+
+  write();
+  read();
+  if (sourceDone_ && !filled_ && (closeSinkOnEof_ || closing_)) finish();
+}
+
+void BufferRelay::finish() {
+  if (finished_) return;
+  finished_ = true;
+
+  boost::system::error_code ec;
+  deadline_.cancel(ec);
+  if (readDataHandler_) readDataHandler_(nullptr, 0);
+  if (writeDataHandler_) writeDataHandler_(nullptr, 0);
+
+  source_.close(ec);
+  sink_.close(ec);
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
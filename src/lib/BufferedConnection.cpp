@@ -1,42 +1,49 @@
 #include <yandex/contest/invoker/flowctl/interactive/BufferedConnection.hpp>
 
+#include "RelayUtility.hpp"
+
+#include <yandex/contest/invoker/flowctl/interactive/BufferRelay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/SpliceRelay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/ThreadedRelay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/UringRelay.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/VectoredRelay.hpp>
+
 #include <yandex/contest/StreamLog.hpp>
 
 #include <boost/asio/detail/signal_init.hpp>
 
+#include <fcntl.h>
+
 namespace yandex {
 namespace contest {
 namespace invoker {
 namespace flowctl {
 namespace interactive {
 
+namespace {
+constexpr unsigned URING_ENTRIES = 16;
+constexpr std::size_t URING_BUFFER_SIZE = 64 * 1024;
+
+/// File opened by caller, otherwise the one at path.
+system::unistd::Descriptor takeDumpFile(system::unistd::Descriptor &file,
+                                        const boost::filesystem::path &path) {
+  if (file) return std::move(file);
+  return openOutputFile(path);
+}
+}  // namespace
+
 BufferedConnection::BufferedConnection(Connection &interactorSource,
                                        Connection &interactorSink,
                                        Connection &solutionSource,
                                        Connection &solutionSink,
                                        const std::size_t outputLimitBytes)
-    : interactorToSolutionBuffer_(
-          interactorSource, solutionSink,
-          boost::bind(&BufferedConnection::handle_interactor_read, this,
-                      boost::asio::placeholders::error,
-                      boost::asio::placeholders::bytes_transferred),
-          boost::bind(&BufferedConnection::handle_solution_write, this,
-                      boost::asio::placeholders::error,
-                      boost::asio::placeholders::bytes_transferred)),
-      solutionToInteractorBuffer_(
-          solutionSource, interactorSink,
-          boost::bind(&BufferedConnection::handle_solution_read, this,
-                      boost::asio::placeholders::error,
-                      boost::asio::placeholders::bytes_transferred),
-          boost::bind(&BufferedConnection::handle_interactor_write, this,
-                      boost::asio::placeholders::error,
-                      boost::asio::placeholders::bytes_transferred)),
+    : interactorSource_(interactorSource),
+      interactorSink_(interactorSink),
+      solutionSource_(solutionSource),
+      solutionSink_(solutionSink),
       outputLimitBytes_(outputLimitBytes) {
   boost::asio::detail::signal_init<SIGPIPE> sigpipe_init;
 
-  interactorToSolutionBuffer_.set_close_sink_on_eof(false);
-  interactorToSolutionBuffer_.set_discard_on_sink_error(true);
-
   interactorEof.connect([] { STREAM_INFO << "Interactor EOF"; });
 
   solutionEof.connect([] { STREAM_INFO << "Solution EOF"; });
@@ -68,31 +75,169 @@ BufferedConnection::BufferedConnection(Connection &interactorSource,
       });
 }
 
+void BufferedConnection::enableStatistics() {
+  interactorToSolutionMonitor_.reset(new RelayMonitor);
+  solutionToInteractorMonitor_.reset(new RelayMonitor);
+}
+
 void BufferedConnection::start() {
-  if (dumpJudge_) {
-    dumpJudgeStream_.reset(
-        new bunsan::filesystem::ofstream(*dumpJudge_, std::ios::binary));
-    interactorToSolutionBuffer_.set_write_data_handler(boost::bind(
-        &BufferedConnection::handle_interactor_write_data, this, _1, _2));
+  const Relay::Handler interactorReadHandler =
+      boost::bind(&BufferedConnection::handle_interactor_read, this,
+                  boost::asio::placeholders::error,
+                  boost::asio::placeholders::bytes_transferred);
+  const Relay::Handler interactorWriteHandler =
+      boost::bind(&BufferedConnection::handle_interactor_write, this,
+                  boost::asio::placeholders::error,
+                  boost::asio::placeholders::bytes_transferred);
+  const Relay::Handler solutionReadHandler =
+      boost::bind(&BufferedConnection::handle_solution_read, this,
+                  boost::asio::placeholders::error,
+                  boost::asio::placeholders::bytes_transferred);
+  const Relay::Handler solutionWriteHandler =
+      boost::bind(&BufferedConnection::handle_solution_write, this,
+                  boost::asio::placeholders::error,
+                  boost::asio::placeholders::bytes_transferred);
+
+  if (pipeCapacity_) {
+    applyPipeCapacity("interactor source", interactorSource_);
+    applyPipeCapacity("interactor sink", interactorSink_);
+    applyPipeCapacity("solution source", solutionSource_);
+    applyPipeCapacity("solution sink", solutionSink_);
+  }
+
+  if (relayMode_ != Relay::Mode::BUFFERED &&
+      (interactorCoalescing_ || solutionCoalescing_)) {
+    STREAM_WARNING << "Write coalescing applies to buffered relay only, "
+                   << "it is not used by " << relayMode_ << " relay";
+  }
+
+  if (relayMode_ == Relay::Mode::URING) {
+    if (!IoUring::isSupported()) {
+      STREAM_WARNING << "io_uring is not supported, "
+                     << "falling back to buffered relay";
+    } else {
+      try {
+        uringLoop_.reset(new UringLoop(interactorSource_.get_io_service(),
+                                       URING_ENTRIES, 2,
+                                       relayBufferSize_ ? relayBufferSize_
+                                                        : URING_BUFFER_SIZE));
+      } catch (std::exception &e) {
+        STREAM_WARNING << "Unable to initialize io_uring: " << e.what()
+                       << ", falling back to buffered relay";
+      }
+    }
   }
 
-  if (dumpSolution_) {
-    dumpSolutionStream_.reset(
-        new bunsan::filesystem::ofstream(*dumpSolution_, std::ios::binary));
-    solutionToInteractorBuffer_.set_read_data_handler(boost::bind(
-        &BufferedConnection::handle_solution_read_data, this, _1, _2));
+  // judge's dump contains data written to solution
+  if (relayMode_ == Relay::Mode::THREADED) {
+    std::unique_ptr<ThreadedRelay> relay(
+        new ThreadedRelay(interactorSource_, solutionSink_,
+                          interactorReadHandler, solutionWriteHandler,
+                          relayBufferSize_
+                              ? relayBufferSize_
+                              : ThreadedRelay::DEFAULT_BUFFER_SIZE));
+    if (dumpJudge_) relay->setWriteDataHandler(openJudgeDump());
+    relay->setReadLimit(outputLimitBytes_);
+    interactorToSolution_ = std::move(relay);
+  } else if (relayMode_ == Relay::Mode::VECTORED) {
+    std::unique_ptr<VectoredRelay> relay(
+        new VectoredRelay(interactorSource_, solutionSink_,
+                          interactorReadHandler, solutionWriteHandler,
+                          relayBufferSize_
+                              ? relayBufferSize_
+                              : VectoredRelay::DEFAULT_BUFFER_SIZE));
+    if (dumpJudge_) relay->setWriteDataHandler(openJudgeDump());
+    interactorToSolution_ = std::move(relay);
+  } else if (uringLoop_) {
+    std::unique_ptr<UringRelay> relay(
+        new UringRelay(*uringLoop_, 0, interactorSource_, solutionSink_,
+                       interactorReadHandler, solutionWriteHandler));
+    if (dumpJudge_) relay->setWriteDataHandler(openJudgeDump());
+    interactorToSolution_ = std::move(relay);
+  } else if (useSplice(interactorSource_, solutionSink_,
+                       dumpJudge_.is_initialized())) {
+    std::unique_ptr<SpliceRelay> relay(
+        new SpliceRelay(interactorSource_, solutionSink_,
+                        interactorReadHandler, solutionWriteHandler));
+    if (pipeCapacity_)
+      STREAM_INFO << "Using " << relay->setCapacity(pipeCapacity_)
+                  << " bytes splice pipe capacity";
+    if (dumpJudge_) {
+      judgeSpliceDump_.reset(
+          new SpliceDump(interactorSource_.get_io_service(),
+                         takeDumpFile(dumpJudgeFile_, *dumpJudge_)));
+      relay->setWriteDump(*judgeSpliceDump_);
+    }
+    interactorToSolution_ = std::move(relay);
+  } else {
+    std::unique_ptr<BufferRelay> relay =
+        makeBufferRelay(interactorSource_, solutionSink_,
+                        interactorReadHandler, solutionWriteHandler,
+                        interactorCoalescing_);
+    if (dumpJudge_) relay->setWriteDataHandler(openJudgeDump());
+    interactorToSolution_ = std::move(relay);
+  }
+  interactorToSolution_->setCloseSinkOnEof(false);
+  interactorToSolution_->setDiscardOnSinkError(true);
+
+  // solution's dump contains data read from solution
+  if (relayMode_ == Relay::Mode::THREADED) {
+    std::unique_ptr<ThreadedRelay> relay(
+        new ThreadedRelay(solutionSource_, interactorSink_,
+                          solutionReadHandler, interactorWriteHandler,
+                          relayBufferSize_
+                              ? relayBufferSize_
+                              : ThreadedRelay::DEFAULT_BUFFER_SIZE));
+    if (dumpSolution_) relay->setReadDataHandler(openSolutionDump());
+    relay->setReadLimit(outputLimitBytes_);
+    solutionToInteractor_ = std::move(relay);
+  } else if (relayMode_ == Relay::Mode::VECTORED) {
+    std::unique_ptr<VectoredRelay> relay(
+        new VectoredRelay(solutionSource_, interactorSink_,
+                          solutionReadHandler, interactorWriteHandler,
+                          relayBufferSize_
+                              ? relayBufferSize_
+                              : VectoredRelay::DEFAULT_BUFFER_SIZE));
+    if (dumpSolution_) relay->setReadDataHandler(openSolutionDump());
+    solutionToInteractor_ = std::move(relay);
+  } else if (uringLoop_) {
+    std::unique_ptr<UringRelay> relay(
+        new UringRelay(*uringLoop_, 1, solutionSource_, interactorSink_,
+                       solutionReadHandler, interactorWriteHandler));
+    if (dumpSolution_) relay->setReadDataHandler(openSolutionDump());
+    solutionToInteractor_ = std::move(relay);
+  } else if (useSplice(solutionSource_, interactorSink_, false)) {
+    std::unique_ptr<SpliceRelay> relay(
+        new SpliceRelay(solutionSource_, interactorSink_, solutionReadHandler,
+                        interactorWriteHandler));
+    if (pipeCapacity_)
+      STREAM_INFO << "Using " << relay->setCapacity(pipeCapacity_)
+                  << " bytes splice pipe capacity";
+    if (dumpSolution_) {
+      solutionSpliceDump_.reset(
+          new SpliceDump(solutionSource_.get_io_service(),
+                         takeDumpFile(dumpSolutionFile_, *dumpSolution_)));
+      relay->setReadDump(*solutionSpliceDump_);
+    }
+    solutionToInteractor_ = std::move(relay);
+  } else {
+    std::unique_ptr<BufferRelay> relay =
+        makeBufferRelay(solutionSource_, interactorSink_, solutionReadHandler,
+                        interactorWriteHandler, solutionCoalescing_);
+    if (dumpSolution_) relay->setReadDataHandler(openSolutionDump());
+    solutionToInteractor_ = std::move(relay);
   }
 
-  interactorToSolutionBuffer_.start();
-  solutionToInteractorBuffer_.start();
+  interactorToSolution_->start();
+  solutionToInteractor_->start();
 }
 
 void BufferedConnection::closeInteractorToSolution() {
-  interactorToSolutionBuffer_.close();
+  if (interactorToSolution_) interactorToSolution_->close();
 }
 
 void BufferedConnection::closeSolutionToInteractor() {
-  solutionToInteractorBuffer_.close();
+  if (solutionToInteractor_) solutionToInteractor_->close();
 }
 
 void BufferedConnection::close() {
@@ -101,20 +246,123 @@ void BufferedConnection::close() {
 }
 
 void BufferedConnection::terminateInteractorToSolution() {
-  interactorToSolutionBuffer_.terminate();
+  if (interactorToSolution_) interactorToSolution_->terminate();
 }
 
 void BufferedConnection::terminateSolutionToInteractor() {
-  solutionToInteractorBuffer_.terminate();
+  if (solutionToInteractor_) solutionToInteractor_->terminate();
 }
 
 void BufferedConnection::terminate() {
   terminateInteractorToSolution();
   terminateSolutionToInteractor();
+  if (uringLoop_) uringLoop_->close();
+}
+
+void BufferedConnection::flushDumps() {
+  if (judgeAsyncDump_) judgeAsyncDump_->close();
+  if (solutionAsyncDump_) solutionAsyncDump_->close();
+}
+
+boost::optional<AsyncDump::Statistics>
+BufferedConnection::judgeDumpStatistics() const {
+  if (!judgeAsyncDump_) return boost::none;
+  return judgeAsyncDump_->statistics();
+}
+
+boost::optional<AsyncDump::Statistics>
+BufferedConnection::solutionDumpStatistics() const {
+  if (!solutionAsyncDump_) return boost::none;
+  return solutionAsyncDump_->statistics();
+}
+
+boost::optional<RelayStatistics>
+BufferedConnection::interactorToSolutionStatistics() const {
+  if (!interactorToSolutionMonitor_) return boost::none;
+  return interactorToSolutionMonitor_->statistics();
+}
+
+boost::optional<RelayStatistics>
+BufferedConnection::solutionToInteractorStatistics() const {
+  if (!solutionToInteractorMonitor_) return boost::none;
+  return solutionToInteractorMonitor_->statistics();
+}
+
+Relay::DataHandler BufferedConnection::openJudgeDump() {
+  if (asyncDump_) {
+    judgeAsyncDump_.reset(new AsyncDump(
+        takeDumpFile(dumpJudgeFile_, *dumpJudge_), *asyncDump_));
+  } else {
+    dumpJudgeFile_ = takeDumpFile(dumpJudgeFile_, *dumpJudge_);
+  }
+  return boost::bind(&BufferedConnection::handle_interactor_write_data, this,
+                     _1, _2);
+}
+
+Relay::DataHandler BufferedConnection::openSolutionDump() {
+  if (asyncDump_) {
+    solutionAsyncDump_.reset(new AsyncDump(
+        takeDumpFile(dumpSolutionFile_, *dumpSolution_), *asyncDump_));
+  } else {
+    dumpSolutionFile_ = takeDumpFile(dumpSolutionFile_, *dumpSolution_);
+  }
+  return boost::bind(&BufferedConnection::handle_solution_read_data, this, _1,
+                     _2);
+}
+
+bool BufferedConnection::useSplice(Connection &source, Connection &sink,
+                                   const bool writeDump) {
+  if (relayMode_ != Relay::Mode::SPLICE) return false;
+  if (!SpliceRelay::isSupported(source, sink, writeDump)) {
+    STREAM_WARNING << "File descriptors " << source.native_handle() << " > "
+                   << sink.native_handle() << " do not support splice, "
+                   << "falling back to buffered relay";
+    return false;
+  }
+  return true;
+}
+
+void BufferedConnection::applyPipeCapacity(const char *const name,
+                                           Connection &connection) {
+  const int applied = ::fcntl(connection.native_handle(), F_SETPIPE_SZ,
+                              static_cast<int>(pipeCapacity_));
+  if (applied < 0) {
+    STREAM_WARNING << "Unable to set " << name << " pipe capacity to "
+                   << pipeCapacity_ << ": "
+                   << boost::system::error_code(
+                          errno, boost::system::system_category())
+                          .message();
+  } else {
+    STREAM_INFO << "Using " << applied << " bytes " << name
+                << " pipe capacity";
+  }
+}
+
+std::unique_ptr<BufferRelay> BufferedConnection::makeBufferRelay(
+    Connection &source, Connection &sink, const Relay::Handler &readHandler,
+    const Relay::Handler &writeHandler,
+    const boost::optional<BufferRelay::CoalescingOptions> &coalescing) {
+  std::unique_ptr<BufferRelay> relay(new BufferRelay(
+      source, sink, readHandler, writeHandler,
+      relayBufferSize_ ? relayBufferSize_ : BufferRelay::DEFAULT_BUFFER_SIZE));
+  STREAM_INFO << "Using " << relay->bufferSize() << " bytes relay buffer";
+  if (maxRelayBufferSize_) {
+    relay->setMaxBufferSize(maxRelayBufferSize_);
+    STREAM_INFO << "Relay buffer may grow up to " << maxRelayBufferSize_
+                << " bytes";
+  }
+  if (coalescing) {
+    STREAM_INFO << "Coalescing writes for at most "
+                << coalescing->delay.count() << " us";
+    relay->setCoalescing(*coalescing);
+  }
+  return relay;
 }
 
 void BufferedConnection::handle_interactor_read(
     const boost::system::error_code &ec, const std::size_t size) {
+  if (interactorToSolutionMonitor_) interactorToSolutionMonitor_->read(size);
+  if (size) thinkTimeMonitor_.interactorRead();
   interactorOutputBytes_ += size;
   if (interactorOutputBytes_ > outputLimitBytes_) {
     interactorOutputLimitExceeded();
@@ -132,6 +380,8 @@ void BufferedConnection::handle_interactor_read(
 
 void BufferedConnection::handle_interactor_write(
     const boost::system::error_code &ec, const std::size_t size) {
+  if (solutionToInteractorMonitor_) solutionToInteractorMonitor_->write(size);
+  if (size) thinkTimeMonitor_.interactorWritten();
   if (ec) {
     interactorWriteError(ec, size);
   }
@@ -139,19 +389,29 @@ void BufferedConnection::handle_interactor_write(
 
 void BufferedConnection::handle_interactor_write_data(const char *const data,
                                                       const std::size_t size) {
-  if (!dumpJudgeStream_) return;
+  if (judgeAsyncDump_) {
+    if (data) judgeAsyncDump_->write(data, size);
+    return;
+  }
 
-  if (data) {
-    BUNSAN_FILESYSTEM_FSTREAM_WRAP_BEGIN(*dumpJudgeStream_) {
-      dumpJudgeStream_->write(data, size);
-    } BUNSAN_FILESYSTEM_FSTREAM_WRAP_END(*dumpJudgeStream_)
-  } else {
-    dumpJudgeStream_.reset();
+  if (!dumpJudgeFile_) return;
+
+  try {
+    if (data) {
+      writeAll(dumpJudgeFile_.get(), data, size);
+    } else {
+      dumpJudgeFile_.close();
+    }
+  } catch (...) {
+    dumpJudgeFile_ = system::unistd::Descriptor();
+    dumpFailed("judge's");
   }
 }
 
 void BufferedConnection::handle_solution_read(
     const boost::system::error_code &ec, const std::size_t size) {
+  if (solutionToInteractorMonitor_) solutionToInteractorMonitor_->read(size);
+  if (size) thinkTimeMonitor_.solutionRead();
   solutionOutputBytes_ += size;
   if (solutionOutputBytes_ > outputLimitBytes_) {
     solutionOutputLimitExceeded();
@@ -169,24 +429,49 @@ void BufferedConnection::handle_solution_read(
 
 void BufferedConnection::handle_solution_read_data(const char *const data,
                                                    const std::size_t size) {
-  if (!dumpSolutionStream_) return;
+  if (solutionAsyncDump_) {
+    if (data) solutionAsyncDump_->write(data, size);
+    return;
+  }
 
-  if (data) {
-    BUNSAN_FILESYSTEM_FSTREAM_WRAP_BEGIN(*dumpSolutionStream_) {
-      dumpSolutionStream_->write(data, size);
-    } BUNSAN_FILESYSTEM_FSTREAM_WRAP_END(*dumpSolutionStream_)
-  } else {
-    dumpSolutionStream_.reset();
+  if (!dumpSolutionFile_) return;
+
+  try {
+    if (data) {
+      writeAll(dumpSolutionFile_.get(), data, size);
+    } else {
+      dumpSolutionFile_.close();
+    }
+  } catch (...) {
+    dumpSolutionFile_ = system::unistd::Descriptor();
+    dumpFailed("solution's");
   }
 }
 
 void BufferedConnection::handle_solution_write(
     const boost::system::error_code &ec, const std::size_t size) {
+  if (interactorToSolutionMonitor_) interactorToSolutionMonitor_->write(size);
+  if (size) thinkTimeMonitor_.solutionWritten();
   if (ec) {
     solutionWriteError(ec, size);
   }
 }
 
+void BufferedConnection::dumpFailed(const char *const name) {
+  const std::exception_ptr error = std::current_exception();
+  try {
+    std::rethrow_exception(error);
+  } catch (std::exception &e) {
+    STREAM_ERROR << "Unable to write " << name << " dump: " << e.what();
+  } catch (...) {
+    STREAM_ERROR << "Unable to write " << name << " dump";
+  }
+
+  // threaded relay calls data handlers from its own threads
+  interactorSource_.get_io_service().post(
+      [this, error] { dumpError(error); });
+}
+
 }  // namespace interactive
 }  // namespace flowctl
 }  // namespace invoker
@@ -1,13 +1,19 @@
 #include <yandex/contest/invoker/flowctl/interactive/CommandIo.hpp>
 
 #include <yandex/contest/invoker/flowctl/interactive/Error.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/PercentEncoding.hpp>
 
-#include <boost/algorithm/string/classification.hpp>
-#include <boost/algorithm/string/split.hpp>
+#include <boost/assert.hpp>
 #include <boost/io/detail/quoted_manip.hpp>
-#include <boost/lexical_cast.hpp>
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/stringize.hpp>
+#include <boost/preprocessor/tuple/elem.hpp>
+#include <boost/preprocessor/tuple/to_seq.hpp>
 
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
 
 namespace yandex {
 namespace contest {
@@ -21,150 +27,445 @@ std::ostream &operator<<(std::ostream &out, const Command &command) {
   return out;
 }
 
-static bool isDigit(const char c) { return '0' <= c && c <= '9'; }
+namespace {
+struct CommandNameEntry {
+  const char *name;
+  std::size_t size;
+  CommandName value;
+};
 
-static bool isPermitted(const char c) {
-  return isDigit(c) || ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
-         c == '_';
+#define YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_NAME_ENTRY( \
+    R, DATA, ELEM)                                                     \
+  {BOOST_PP_STRINGIZE(BOOST_PP_TUPLE_ELEM(2, 0, ELEM)),                \
+   sizeof(BOOST_PP_STRINGIZE(BOOST_PP_TUPLE_ELEM(2, 0, ELEM))) - 1,    \
+   BOOST_PP_TUPLE_ELEM(2, 0, ELEM)},
+
+constexpr CommandNameEntry COMMAND_NAMES[] = {BOOST_PP_SEQ_FOR_EACH(
+    YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_NAME_ENTRY, ~,
+    BOOST_PP_TUPLE_TO_SEQ(
+        YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_NAMES))};
+
+#undef YANDEX_CONTEST_INVOKER_FLOWCTL_INTERACTIVE_COMMAND_NAME_ENTRY
+
+constexpr std::size_t COMMAND_NAMES_SIZE =
+    sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]);
+
+/*
+ * Perfect hash of command names.
+ *
+ * Name is reduced to a key made of its length and its first,
+ * middle and last characters, key is mapped to a slot
+ * by multiplicative hashing. Multiplier is searched at compile time
+ * so that every name from COMMAND_NAMES gets its own slot,
+ * parsing is a single table lookup followed by one comparison.
+ */
+
+constexpr unsigned COMMAND_NAME_HASH_BITS = 6;
+constexpr std::size_t COMMAND_NAME_HASH_SIZE = 1 << COMMAND_NAME_HASH_BITS;
+constexpr unsigned COMMAND_NAME_HASH_ATTEMPTS = 256;
+
+static_assert(COMMAND_NAMES_SIZE < COMMAND_NAME_HASH_SIZE,
+              "Command name hash table is too small");
+
+constexpr std::uint32_t commandNameKey(const char *const name,
+                                       const std::size_t size) {
+  return static_cast<std::uint32_t>(size) ^
+         (static_cast<std::uint32_t>(static_cast<unsigned char>(name[0]))
+          << 8) ^
+         (static_cast<std::uint32_t>(
+              static_cast<unsigned char>(name[size / 2])) << 16) ^
+         (static_cast<std::uint32_t>(
+              static_cast<unsigned char>(name[size - 1])) << 24);
 }
 
-std::string encodeCommandValue(const std::string &value) {
-  try {
-    std::ostringstream sout;
-    for (const char c : value) {
-      if (isPermitted(c)) {
-        sout << c;
-      } else {
-        sout << '%' << std::hex << std::setw(2) << std::setfill('0')
-             << static_cast<unsigned>(static_cast<unsigned char>(c));
-      }
-    }
-    return sout.str();
-  } catch (std::exception &) {
-    BOOST_THROW_EXCEPTION(EncodeCommandValueError()
-                          << bunsan::enable_nested_current());
-  }
+constexpr std::size_t commandNameSlot(const std::uint32_t key,
+                                      const std::uint32_t multiplier) {
+  return static_cast<std::uint32_t>(key * multiplier) >>
+         (32 - COMMAND_NAME_HASH_BITS);
 }
 
-std::string decodeCommandValue(const std::string &data) {
-  try {
-    std::ostringstream sout;
-    int complexPos = 0;
-    unsigned buf = 0;
-    for (const char c : data) {
-      switch (complexPos) {
-        case 0:
-          switch (c) {
-            case '%':
-              complexPos = 2;
-              break;
-            default:
-              if (!isPermitted(c))
-                BOOST_THROW_EXCEPTION(
-                    DecodeCommandValueCharacterIsNotPermittedError()
-                    << DecodeCommandValueCharacterIsNotPermittedError::
-                        character(c));
-              sout << c;
-          }
-          break;
-        case 1:
-          if (!isDigit(c))
-            BOOST_THROW_EXCEPTION(
-                DecodeCommandValueDigitExpectedError()
-                << DecodeCommandValueDigitExpectedError::character(c));
-          buf += c - '0';
-          sout << static_cast<char>(static_cast<unsigned char>(buf));
-          complexPos = 0;
-          break;
-        case 2:
-          if (!isDigit(c))
-            BOOST_THROW_EXCEPTION(
-                DecodeCommandValueDigitExpectedError()
-                << DecodeCommandValueDigitExpectedError::character(c));
-          buf = 0x10 * (c - '0');
-          complexPos = 1;
-          break;
-      }
+constexpr std::size_t commandNameEntrySlot(const std::size_t i,
+                                           const std::uint32_t multiplier) {
+  return commandNameSlot(
+      commandNameKey(COMMAND_NAMES[i].name, COMMAND_NAMES[i].size),
+      multiplier);
+}
+
+constexpr bool commandNameCollides(const std::uint32_t multiplier,
+                                   const std::size_t i, const std::size_t j) {
+  return j < COMMAND_NAMES_SIZE &&
+         (commandNameEntrySlot(i, multiplier) ==
+              commandNameEntrySlot(j, multiplier) ||
+          commandNameCollides(multiplier, i, j + 1));
+}
+
+constexpr bool isPerfectCommandNameHash(const std::uint32_t multiplier,
+                                        const std::size_t i = 0) {
+  return i == COMMAND_NAMES_SIZE ||
+         (!commandNameCollides(multiplier, i, i + 1) &&
+          isPerfectCommandNameHash(multiplier, i + 1));
+}
+
+constexpr std::uint32_t commandNameHashMultiplier(const unsigned attempt = 0) {
+  // odd multipliers derived from golden ratio
+  return attempt == COMMAND_NAME_HASH_ATTEMPTS
+             ? 0
+             : isPerfectCommandNameHash(0x9E3779B1u + 2 * attempt)
+                   ? 0x9E3779B1u + 2 * attempt
+                   : commandNameHashMultiplier(attempt + 1);
+}
+
+constexpr std::uint32_t COMMAND_NAME_HASH_MULTIPLIER =
+    commandNameHashMultiplier();
+
+static_assert(COMMAND_NAME_HASH_MULTIPLIER != 0,
+              "Unable to find perfect hash for command names, "
+              "increase COMMAND_NAME_HASH_BITS");
+
+constexpr std::uint8_t COMMAND_NAME_HASH_EMPTY = 0xFF;
+
+static_assert(COMMAND_NAMES_SIZE < COMMAND_NAME_HASH_EMPTY,
+              "Too many command names");
+
+using CommandNameHashTable =
+    std::array<std::uint8_t, COMMAND_NAME_HASH_SIZE>;
+
+const CommandNameHashTable &commandNameHashTable() {
+  static const CommandNameHashTable table = [] {
+    CommandNameHashTable table;
+    table.fill(COMMAND_NAME_HASH_EMPTY);
+    for (std::size_t i = 0; i < COMMAND_NAMES_SIZE; ++i)
+      table[commandNameEntrySlot(i, COMMAND_NAME_HASH_MULTIPLIER)] = i;
+    return table;
+  }();
+  return table;
+}
+
+class CommandIoCategory : public boost::system::error_category {
+ public:
+  const char *name() const noexcept override { return "command_io"; }
+
+  std::string message(const int ev) const override {
+    switch (static_cast<CommandIoErrc>(ev)) {
+      case CommandIoErrc::CHARACTER_IS_NOT_PERMITTED:
+        return "Character is not permitted";
+      case CommandIoErrc::DIGIT_EXPECTED:
+        return "Digit expected";
+      case CommandIoErrc::INVALID_ESCAPE_SEQUENCE:
+        return "Invalid escape sequence";
+      case CommandIoErrc::UNKNOWN_COMMAND_NAME:
+        return "Unknown command name";
+      case CommandIoErrc::UNEXPECTED_VALUE:
+        return "Flag command has value";
+      case CommandIoErrc::INSUFFICIENT_DATA:
+        return "Insufficient data";
+      case CommandIoErrc::INVALID_LENGTH:
+        return "Invalid length";
     }
-    if (complexPos)
+    return "Unknown error";
+  }
+};
+
+[[noreturn]] void throwDecodeCommandValueError(const CommandIoErrc errc,
+                                               const StringRef data,
+                                               const std::size_t pos) {
+  BOOST_ASSERT(pos <= data.size());
+  switch (errc) {
+    case CommandIoErrc::CHARACTER_IS_NOT_PERMITTED:
+      BOOST_THROW_EXCEPTION(
+          DecodeCommandValueCharacterIsNotPermittedError()
+          << DecodeCommandValueCharacterIsNotPermittedError::character(
+                 data[pos]));
+    case CommandIoErrc::DIGIT_EXPECTED:
+      BOOST_THROW_EXCEPTION(
+          DecodeCommandValueDigitExpectedError()
+          << DecodeCommandValueDigitExpectedError::character(data[pos]));
+    default:
       BOOST_THROW_EXCEPTION(
           DecodeCommandValueError()
-          << DecodeCommandValueError::data(data)
+          << DecodeCommandValueError::data(data.to_string())
           << DecodeCommandValueError::message("Invalid escape sequence."));
-    return sout.str();
-  } catch (DecodeCommandValueError &) {
-    throw;
-  } catch (std::exception &) {
-    BOOST_THROW_EXCEPTION(DecodeCommandValueError()
-                          << DecodeCommandValueError::data(data)
-                          << bunsan::enable_nested_current());
   }
 }
+}  // namespace
 
-std::string encodeCommand(const Command &command) {
-  try {
-    std::ostringstream sout;
-    sout << command.first;
-    if (!command.second.empty())
-      sout << '=' << encodeCommandValue(command.second);
-    return sout.str();
-  } catch (std::exception &) {
-    BOOST_THROW_EXCEPTION(EncodeCommandError()
-                          << bunsan::enable_nested_current());
+const boost::system::error_category &commandIoCategory() {
+  static const CommandIoCategory category;
+  return category;
+}
+
+boost::system::error_code make_error_code(const CommandIoErrc errc) {
+  return boost::system::error_code(static_cast<int>(errc),
+                                   commandIoCategory());
+}
+
+bool parseCommandName(const StringRef data, CommandName &name) {
+  if (data.empty()) return false;
+  const std::uint8_t i = commandNameHashTable()[commandNameSlot(
+      commandNameKey(data.data(), data.size()), COMMAND_NAME_HASH_MULTIPLIER)];
+  if (i == COMMAND_NAME_HASH_EMPTY) return false;
+  const CommandNameEntry &entry = COMMAND_NAMES[i];
+  if (entry.size != data.size() ||
+      std::memcmp(entry.name, data.data(), data.size()) != 0)
+    return false;
+  name = entry.value;
+  return true;
+}
+
+StringRef commandNameString(const CommandName name) {
+  for (const CommandNameEntry &entry : COMMAND_NAMES) {
+    if (entry.value == name) return StringRef(entry.name, entry.size);
+  }
+  BOOST_ASSERT_MSG(false, "Unknown command name");
+  return StringRef();
+}
+
+namespace {
+std::size_t maxEncodedSize(const CommandName name, const StringRef value) {
+  return commandNameString(name).size() + 1 +
+         maxEncodedCommandValueSize(value.size());
+}
+
+std::size_t encodeTo(const CommandName name, const StringRef value,
+                     char *const out) {
+  const StringRef nameString = commandNameString(name);
+  std::memcpy(out, nameString.data(), nameString.size());
+  std::size_t size = nameString.size();
+  if (!value.empty()) {
+    out[size++] = '=';
+    size += encodeCommandValueTo(value, out + size);
+  }
+  return size;
+}
+}  // namespace
+
+std::size_t maxEncodedCommandSize(const Command &command) {
+  return maxEncodedSize(command.first, command.second);
+}
+
+std::size_t maxEncodedCommandPackSize(const CommandPack &pack) {
+  // separator or terminator for each command, terminator of empty pack
+  std::size_t size = 1;
+  for (const auto &command : pack)
+    size += maxEncodedSize(command.first, command.second);
+  return size;
+}
+
+std::size_t maxEncodedCommandPackSize(const CommandSet &set) {
+  std::size_t size = 1;
+  for (const CommandName name : set)
+    size += maxEncodedSize(name, set.value(name));
+  return size;
+}
+
+std::size_t encodeCommandValueTo(const StringRef value, char *const out) {
+  return PercentEncoding::instance().encode(value.data(), value.size(), out);
+}
+
+std::size_t encodeCommandTo(const Command &command, char *const out) {
+  return encodeTo(command.first, command.second, out);
+}
+
+std::size_t encodeCommandPackTo(const CommandPack &pack, char *const out) {
+  std::size_t size = 0;
+  bool first = true;
+  for (const auto &command : pack) {
+    if (!first) out[size++] = '&';
+    first = false;
+    size += encodeTo(command.first, command.second, out + size);
+  }
+  out[size++] = ';';
+  return size;
+}
+
+std::size_t encodeCommandPackTo(const CommandSet &set, char *const out) {
+  std::size_t size = 0;
+  bool first = true;
+  for (const CommandName name : set) {
+    if (!first) out[size++] = '&';
+    first = false;
+    size += encodeTo(name, set.value(name), out + size);
+  }
+  out[size++] = ';';
+  return size;
+}
+
+void appendEncodedCommandValue(const StringRef value, std::string &out) {
+  const std::size_t size = out.size();
+  out.resize(size + maxEncodedCommandValueSize(value.size()));
+  out.resize(size + encodeCommandValueTo(value, &out[size]));
+}
+
+void appendEncodedCommand(const Command &command, std::string &out) {
+  const std::size_t size = out.size();
+  out.resize(size + maxEncodedCommandSize(command));
+  out.resize(size + encodeCommandTo(command, &out[size]));
+}
+
+void appendEncodedCommandPack(const CommandPack &pack, std::string &out) {
+  const std::size_t size = out.size();
+  out.resize(size + maxEncodedCommandPackSize(pack));
+  out.resize(size + encodeCommandPackTo(pack, &out[size]));
+}
+
+void appendEncodedCommandPack(const CommandSet &set, std::string &out) {
+  const std::size_t size = out.size();
+  out.resize(size + maxEncodedCommandPackSize(set));
+  out.resize(size + encodeCommandPackTo(set, &out[size]));
+}
+
+std::size_t decodeCommandValueTo(const StringRef data, std::string &value,
+                                 boost::system::error_code &ec) {
+  value.resize(data.size());
+  std::size_t size = 0;
+  const std::size_t pos = PercentEncoding::instance().decode(
+      data.data(), data.size(), &value[0], size, ec);
+  value.resize(size);
+  return pos;
+}
+
+std::size_t decodeCommandTo(const StringRef data, Command &command,
+                            boost::system::error_code &ec) {
+  ec.clear();
+  const std::size_t pos = std::min(data.find('='), data.size());
+  if (!parseCommandName(data.substr(0, pos), command.first)) {
+    ec = CommandIoErrc::UNKNOWN_COMMAND_NAME;
+    return 0;
+  }
+  if (pos + 1 >= data.size()) {
+    command.second.clear();
+    return data.size();
+  }
+  if (!isParameter(command.first)) {
+    ec = CommandIoErrc::UNEXPECTED_VALUE;
+    return pos;
+  }
+  return pos + 1 +
+         decodeCommandValueTo(data.substr(pos + 1), command.second, ec);
+}
+
+std::size_t decodeCommandPackTo(const StringRef data, CommandPack &pack,
+                                boost::system::error_code &ec) {
+  ec.clear();
+  pack.clear();
+  Command command;
+  std::size_t begin = 0;
+  while (begin < data.size()) {
+    std::size_t end = begin;
+    while (end < data.size() && data[end] != '&' && data[end] != ';') ++end;
+    // empty commands are skipped
+    if (end != begin) {
+      const std::size_t size =
+          decodeCommandTo(data.substr(begin, end - begin), command, ec);
+      if (ec) return begin + size;
+      pack.emplace(command);
+    }
+    begin = end + 1;
   }
+  return data.size();
+}
+
+std::size_t decodeCommandPackTo(const StringRef data, CommandSet &set,
+                                boost::system::error_code &ec) {
+  ec.clear();
+  set.clear();
+  std::size_t begin = 0;
+  while (begin < data.size()) {
+    std::size_t end = begin;
+    while (end < data.size() && data[end] != '&' && data[end] != ';') ++end;
+    // empty commands are skipped
+    if (end != begin) {
+      const StringRef command = data.substr(begin, end - begin);
+      const std::size_t pos = std::min(command.find('='), command.size());
+      CommandName name;
+      if (!parseCommandName(command.substr(0, pos), name)) {
+        ec = CommandIoErrc::UNKNOWN_COMMAND_NAME;
+        return begin;
+      }
+      if (isParameter(name)) {
+        std::string &value = set.parameter(name);
+        if (pos < command.size()) {
+          const std::size_t size =
+              decodeCommandValueTo(command.substr(pos + 1), value, ec);
+          if (ec) return begin + pos + 1 + size;
+        } else {
+          value.clear();
+        }
+      } else if (pos + 1 < command.size()) {
+        ec = CommandIoErrc::UNEXPECTED_VALUE;
+        return begin + pos;
+      } else {
+        set.insert(name);
+      }
+    }
+    begin = end + 1;
+  }
+  return data.size();
+}
+
+std::string encodeCommandValue(const std::string &value) {
+  std::string data;
+  appendEncodedCommandValue(value, data);
+  return data;
+}
+
+std::string decodeCommandValue(const std::string &data) {
+  std::string value;
+  boost::system::error_code ec;
+  const std::size_t pos = decodeCommandValueTo(data, value, ec);
+  if (ec)
+    throwDecodeCommandValueError(static_cast<CommandIoErrc>(ec.value()), data,
+                                 pos);
+  return value;
+}
+
+std::string encodeCommand(const Command &command) {
+  std::string data;
+  appendEncodedCommand(command, data);
+  return data;
 }
 
 Command decodeCommand(const std::string &data) {
-  try {
-    const std::size_t pos = data.find('=');
-    Command command;
-    command.first = boost::lexical_cast<CommandName>(data.substr(0, pos));
-    if (pos != std::string::npos)
-      command.second = decodeCommandValue(data.substr(pos + 1));
-    return command;
-  } catch (std::exception &) {
+  Command command;
+  boost::system::error_code ec;
+  decodeCommandTo(data, command, ec);
+  if (ec)
     BOOST_THROW_EXCEPTION(DecodeCommandError()
                           << DecodeCommandError::data(data)
-                          << bunsan::enable_nested_current());
-  }
+                          << DecodeCommandError::message(ec.message()));
+  return command;
 }
 
 std::string encodeCommandPack(const CommandPack &pack) {
-  try {
-    std::ostringstream sout;
-    bool first = true;
-    for (const Command &command : pack) {
-      if (!first) sout << '&';
-      first = false;
-
-      sout << encodeCommand(command);
-    }
-    sout << ';';
-    return sout.str();
-  } catch (std::exception &) {
-    BOOST_THROW_EXCEPTION(EncodeCommandPackError()
-                          << bunsan::enable_nested_current());
-  }
+  std::string data;
+  appendEncodedCommandPack(pack, data);
+  return data;
 }
 
 CommandPack decodeCommandPack(const std::string &data) {
-  try {
-    CommandPack pack;
-
-    std::string data_ = data;
-    std::vector<std::string> encodedCommands;
-    boost::algorithm::split(encodedCommands, data_,
-                            boost::algorithm::is_any_of("&;"),
-                            boost::algorithm::token_compress_on);
-    for (const std::string &encodedCommand : encodedCommands) {
-      if (!encodedCommand.empty()) pack.emplace(decodeCommand(encodedCommand));
-    }
-    return pack;
-  } catch (std::exception &) {
+  CommandPack pack;
+  boost::system::error_code ec;
+  decodeCommandPackTo(data, pack, ec);
+  if (ec)
     BOOST_THROW_EXCEPTION(DecodeCommandPackError()
                           << DecodeCommandPackError::data(data)
-                          << bunsan::enable_nested_current());
-  }
+                          << DecodeCommandPackError::message(ec.message()));
+  return pack;
+}
+
+std::string encodeCommandPack(const CommandSet &set) {
+  std::string data;
+  appendEncodedCommandPack(set, data);
+  return data;
+}
+
+void decodeCommandPack(const std::string &data, CommandSet &set) {
+  boost::system::error_code ec;
+  decodeCommandPackTo(data, set, ec);
+  if (ec)
+    BOOST_THROW_EXCEPTION(DecodeCommandPackError()
+                          << DecodeCommandPackError::data(data)
+                          << DecodeCommandPackError::message(ec.message()));
 }
 
 }  // namespace interactive
@@ -0,0 +1,120 @@
+#include <yandex/contest/invoker/flowctl/interactive/CommandPackDecoder.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/CommandIo.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/Error.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/PercentEncoding.hpp>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+bool isNameCharacter(const char c) {
+  return ('A' <= c && c <= 'Z') || c == '_';
+}
+}  // namespace
+
+CommandPackDecoder::CommandPackDecoder(const Handler &handler)
+    : handler_(handler) {}
+
+void CommandPackDecoder::reset() {
+  state_ = State::NAME;
+  nameSize_ = 0;
+  value_.clear();
+}
+
+std::size_t CommandPackDecoder::feed(const char *const data,
+                                     const std::size_t size) {
+  std::size_t i = 0;
+  while (i < size && state_ != State::COMPLETE) {
+    const char c = data[i];
+    switch (state_) {
+      case State::NAME:
+        if (isNameCharacter(c)) {
+          if (nameSize_ == MAX_NAME_SIZE)
+            BOOST_THROW_EXCEPTION(
+                DecodeCommandPackError()
+                << DecodeCommandPackError::message("Command name is too long"));
+          name_[nameSize_++] = c;
+        } else if (c == '=') {
+          if (!nameSize_)
+            BOOST_THROW_EXCEPTION(
+                DecodeCommandPackError()
+                << DecodeCommandPackError::message("Empty command name"));
+          state_ = State::VALUE;
+        } else if (c == '&' || c == ';') {
+          // empty commands are skipped
+          if (nameSize_) emit();
+          if (c == ';') state_ = State::COMPLETE;
+        } else {
+          BOOST_THROW_EXCEPTION(
+              DecodeCommandValueCharacterIsNotPermittedError()
+              << DecodeCommandValueCharacterIsNotPermittedError::character(c));
+        }
+        ++i;
+        break;
+      case State::VALUE: {
+        const std::size_t run =
+            PercentEncoding::instance().permittedPrefix(data + i, size - i);
+        value_.append(data + i, run);
+        i += run;
+        if (i == size) break;
+        const char t = data[i++];
+        if (t == '%') {
+          state_ = State::ESCAPE_HIGH;
+        } else if (t == '&' || t == ';') {
+          emit();
+          state_ = t == ';' ? State::COMPLETE : State::NAME;
+        } else {
+          BOOST_THROW_EXCEPTION(
+              DecodeCommandValueCharacterIsNotPermittedError()
+              << DecodeCommandValueCharacterIsNotPermittedError::character(t));
+        }
+        break;
+      }
+      case State::ESCAPE_HIGH:
+      case State::ESCAPE_LOW: {
+        const int digit = PercentEncoding::hexDigit(c);
+        if (digit < 0)
+          BOOST_THROW_EXCEPTION(
+              DecodeCommandValueDigitExpectedError()
+              << DecodeCommandValueDigitExpectedError::character(c));
+        if (state_ == State::ESCAPE_HIGH) {
+          escape_ = digit << 4;
+          state_ = State::ESCAPE_LOW;
+        } else {
+          value_.push_back(static_cast<char>(escape_ | digit));
+          state_ = State::VALUE;
+        }
+        ++i;
+        break;
+      }
+      case State::COMPLETE:
+        break;
+    }
+  }
+  return i;
+}
+
+void CommandPackDecoder::emit() {
+  handler_(name(), value_);
+  nameSize_ = 0;
+  value_.clear();
+}
+
+CommandName CommandPackDecoder::name() const {
+  CommandName commandName;
+  if (!parseCommandName(StringRef(name_, nameSize_), commandName))
+    BOOST_THROW_EXCEPTION(DecodeCommandError()
+                          << DecodeCommandError::data(
+                                 std::string(name_, nameSize_)));
+  return commandName;
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
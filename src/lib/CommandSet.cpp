@@ -0,0 +1,94 @@
+#include <yandex/contest/invoker/flowctl/interactive/CommandSet.hpp>
+
+#include <boost/assert.hpp>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+constexpr std::size_t CommandSet::CAPACITY;
+constexpr std::size_t CommandSet::PARAMETERS;
+constexpr CommandSet::Mask CommandSet::PARAMETER_MASK;
+
+namespace {
+constexpr bool isAscending(const std::size_t i = 1) {
+  return i >= detail::COMMAND_SET_NAMES_SIZE ||
+         (detail::COMMAND_SET_NAMES[i - 1] < detail::COMMAND_SET_NAMES[i] &&
+          isAscending(i + 1));
+}
+
+static_assert(isAscending(),
+              "Command names should be declared in ascending order, "
+              "CommandSet iteration order relies on it");
+
+const std::string EMPTY_VALUE;
+}  // namespace
+
+CommandSet::CommandSet(const CommandPack &pack) {
+  for (const auto &command : pack) {
+    if (isParameter(command.first))
+      insert(command.first, command.second);
+    else
+      insert(command.first);
+  }
+}
+
+CommandPack CommandSet::toCommandPack() const {
+  CommandPack pack;
+  for (const CommandName name : *this)
+    pack.emplace_hint(pack.end(), name, value(name));
+  return pack;
+}
+
+const std::string &CommandSet::value(const CommandName name) const {
+  if (!isParameter(name) || !contains(name)) return EMPTY_VALUE;
+  return parameters_[parameterIndex(name)];
+}
+
+std::string &CommandSet::parameter(const CommandName name) {
+  BOOST_ASSERT(isParameter(name));
+  std::string &value = parameters_[parameterIndex(name)];
+  if (!contains(name)) {
+    mask_ |= bit(name);
+    value.clear();
+  }
+  return value;
+}
+
+void CommandSet::insert(const CommandName name) {
+  if (isParameter(name))
+    parameter(name).clear();
+  else
+    mask_ |= bit(name);
+}
+
+void CommandSet::insert(const CommandName name,
+                        const boost::string_ref value) {
+  if (isParameter(name)) {
+    parameter(name).assign(value.data(), value.size());
+  } else {
+    BOOST_ASSERT_MSG(value.empty(), "Flags have no value");
+    mask_ |= bit(name);
+  }
+}
+
+std::size_t CommandSet::parameterIndex(const CommandName name) {
+  // parameters preceding name
+  return __builtin_popcount((bit(name) - 1) & PARAMETER_MASK);
+}
+
+bool operator==(const CommandSet &a, const CommandSet &b) {
+  if (a.mask_ != b.mask_) return false;
+  for (const CommandName name : a) {
+    if (isParameter(name) && a.value(name) != b.value(name)) return false;
+  }
+  return true;
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
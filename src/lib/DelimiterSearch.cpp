@@ -0,0 +1,157 @@
+#include <yandex/contest/invoker/flowctl/interactive/DelimiterSearch.hpp>
+
+#include <boost/assert.hpp>
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define YANDEX_CONTEST_DELIMITER_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+constexpr std::size_t DelimiterSearch::npos;
+
+namespace {
+bool matches(const char *const data, const char *const delimiter,
+             const std::size_t delimiterSize) {
+  // first and last bytes are already compared
+  return delimiterSize <= 2 ||
+         !std::memcmp(data + 1, delimiter + 1, delimiterSize - 2);
+}
+
+std::size_t findScalar(const char *const data, const std::size_t size,
+                       const char *const delimiter,
+                       const std::size_t delimiterSize) {
+  if (size < delimiterSize) return DelimiterSearch::npos;
+  const char *const last = data + size - delimiterSize + 1;
+  const char *pos = data;
+  while (pos < last) {
+    pos = static_cast<const char *>(std::memchr(pos, delimiter[0], last - pos));
+    if (!pos) break;
+    if (pos[delimiterSize - 1] == delimiter[delimiterSize - 1] &&
+        matches(pos, delimiter, delimiterSize))
+      return pos - data;
+    ++pos;
+  }
+  return DelimiterSearch::npos;
+}
+
+#ifdef YANDEX_CONTEST_DELIMITER_SEARCH_X86
+__attribute__((target("sse2"))) std::size_t findSse2(
+    const char *const data, const std::size_t size,
+    const char *const delimiter, const std::size_t delimiterSize) {
+  constexpr std::size_t BLOCK = 16;
+  const __m128i first = _mm_set1_epi8(delimiter[0]);
+  const __m128i last = _mm_set1_epi8(delimiter[delimiterSize - 1]);
+
+  std::size_t i = 0;
+  for (; i + delimiterSize - 1 + BLOCK <= size; i += BLOCK) {
+    const __m128i blockFirst =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    const __m128i blockLast = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(data + i + delimiterSize - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+    while (mask) {
+      const unsigned bit = __builtin_ctz(mask);
+      if (matches(data + i + bit, delimiter, delimiterSize)) return i + bit;
+      mask &= mask - 1;
+    }
+  }
+
+  const std::size_t tail =
+      findScalar(data + i, size - i, delimiter, delimiterSize);
+  return tail == DelimiterSearch::npos ? tail : i + tail;
+}
+
+__attribute__((target("avx2"))) std::size_t findAvx2(
+    const char *const data, const std::size_t size,
+    const char *const delimiter, const std::size_t delimiterSize) {
+  constexpr std::size_t BLOCK = 32;
+  const __m256i first = _mm256_set1_epi8(delimiter[0]);
+  const __m256i last = _mm256_set1_epi8(delimiter[delimiterSize - 1]);
+
+  std::size_t i = 0;
+  for (; i + delimiterSize - 1 + BLOCK <= size; i += BLOCK) {
+    const __m256i blockFirst =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    const __m256i blockLast = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(data + i + delimiterSize - 1));
+    unsigned mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst),
+                         _mm256_cmpeq_epi8(last, blockLast)));
+    while (mask) {
+      const unsigned bit = __builtin_ctz(mask);
+      if (matches(data + i + bit, delimiter, delimiterSize)) return i + bit;
+      mask &= mask - 1;
+    }
+  }
+
+  const std::size_t tail =
+      findSse2(data + i, size - i, delimiter, delimiterSize);
+  return tail == DelimiterSearch::npos ? tail : i + tail;
+}
+#endif
+}  // namespace
+
+DelimiterSearch::Implementation DelimiterSearch::bestImplementation() {
+  if (isSupported(Implementation::AVX2)) return Implementation::AVX2;
+  if (isSupported(Implementation::SSE2)) return Implementation::SSE2;
+  return Implementation::SCALAR;
+}
+
+bool DelimiterSearch::isSupported(const Implementation implementation) {
+  switch (implementation) {
+    case Implementation::SCALAR:
+      return true;
+#ifdef YANDEX_CONTEST_DELIMITER_SEARCH_X86
+    case Implementation::SSE2:
+      return __builtin_cpu_supports("sse2");
+    case Implementation::AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+DelimiterSearch::DelimiterSearch(const std::string &delimiter)
+    : DelimiterSearch(delimiter, bestImplementation()) {}
+
+DelimiterSearch::DelimiterSearch(const std::string &delimiter,
+                                 const Implementation implementation)
+    : delimiter_(delimiter),
+      implementation_(implementation),
+      find_(&findScalar) {
+  BOOST_ASSERT(!delimiter_.empty());
+  BOOST_ASSERT(isSupported(implementation_));
+#ifdef YANDEX_CONTEST_DELIMITER_SEARCH_X86
+  switch (implementation_) {
+    case Implementation::SSE2:
+      find_ = &findSse2;
+      break;
+    case Implementation::AVX2:
+      find_ = &findAvx2;
+      break;
+    default:
+      break;
+  }
+#endif
+}
+
+std::size_t DelimiterSearch::find(const char *const data,
+                                  const std::size_t size) const {
+  return find_(data, size, delimiter_.data(), delimiter_.size());
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
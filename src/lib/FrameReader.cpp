@@ -0,0 +1,152 @@
+#include <yandex/contest/invoker/flowctl/interactive/FrameReader.hpp>
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+constexpr std::size_t READ_SIZE = 64 * 1024;
+}  // namespace
+
+FrameReader::FrameReader(Connection &source, const std::string &delimiter)
+    : source_(source), search_(delimiter) {}
+
+void FrameReader::async_read_frame(const Handler &handler) {
+  async_read_frames(1, handler);
+}
+
+void FrameReader::async_read_frames(const std::size_t count,
+                                    const Handler &handler) {
+  handler_ = handler;
+  consume();
+  mode_ = Mode::FRAMES;
+  remaining_ = count;
+  start();
+}
+
+void FrameReader::async_read_chunk(const std::size_t maxSize,
+                                   const Handler &handler) {
+  BOOST_ASSERT(maxSize > 0);
+  handler_ = handler;
+  consume();
+  mode_ = Mode::CHUNK;
+  limit_ = maxSize;
+  start();
+}
+
+void FrameReader::async_peek(const std::size_t minSize,
+                             const Handler &handler) {
+  handler_ = handler;
+  consume();
+  mode_ = Mode::PEEK;
+  limit_ = minSize;
+  start();
+}
+
+void FrameReader::start() {
+  if (!scan()) {
+    read();
+    return;
+  }
+
+  source_.get_io_service().post(
+      [this] { call(boost::system::error_code()); });
+}
+
+void FrameReader::consume() {
+  begin_ += frameSize_;
+  frameSize_ = 0;
+  scanned_ = 0;
+  if (begin_ == end_) begin_ = end_ = 0;
+}
+
+bool FrameReader::scan() {
+  switch (mode_) {
+    case Mode::FRAMES:
+      return scanFrames();
+    case Mode::CHUNK:
+      frameSize_ = std::min(end_ - begin_, limit_);
+      return frameSize_;
+    case Mode::PEEK:
+      return end_ - begin_ >= limit_;
+  }
+  return false;
+}
+
+bool FrameReader::scanFrames() {
+  const std::size_t delimiterSize = search_.delimiter().size();
+  const std::size_t size = end_ - begin_;
+  while (remaining_) {
+    const std::size_t pos =
+        search_.find(buffer_.data() + begin_ + scanned_, size - scanned_);
+    if (pos == DelimiterSearch::npos) {
+      // delimiter may start in the last delimiterSize - 1 bytes
+      if (size >= frameSize_ + delimiterSize)
+        scanned_ = size - delimiterSize + 1;
+      return false;
+    }
+    frameSize_ = scanned_ + pos + delimiterSize;
+    scanned_ = frameSize_;
+    --remaining_;
+  }
+  return true;
+}
+
+void FrameReader::read() {
+  prepare();
+  source_.async_read_some(
+      boost::asio::buffer(buffer_.data() + end_, buffer_.size() - end_),
+      [this](const boost::system::error_code &ec, const std::size_t size) {
+        complete(ec, size);
+      });
+}
+
+void FrameReader::prepare() {
+  if (buffer_.size() - end_ >= READ_SIZE) return;
+  if (begin_) {
+    std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+    end_ -= begin_;
+    begin_ = 0;
+  }
+  if (buffer_.size() - end_ < READ_SIZE)
+    buffer_.resize(std::max(buffer_.size() * 2, end_ + READ_SIZE));
+}
+
+void FrameReader::complete(const boost::system::error_code &ec,
+                           const std::size_t size) {
+  end_ += size;
+
+  if (ec) {
+    frameSize_ = end_ - begin_;
+    call(ec);
+    return;
+  }
+
+  if (!scan()) {
+    read();
+    return;
+  }
+
+  call(ec);
+}
+
+void FrameReader::call(const boost::system::error_code &ec) {
+  // peeked data is not consumed
+  const std::size_t size = mode_ == Mode::PEEK ? end_ - begin_ : frameSize_;
+  if (mode_ == Mode::PEEK) frameSize_ = 0;
+  const Handler handler = std::move(handler_);
+  handler(ec, buffer_.data() + begin_, size);
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,139 @@
+#include <yandex/contest/invoker/flowctl/interactive/InProcessPipe.hpp>
+
+#include <boost/assert.hpp>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+bool InProcessPipe::ReadEnd::is_open() const {
+  const std::lock_guard<std::mutex> lk(pipe_.lock_);
+  return pipe_.readOpen_;
+}
+
+void InProcessPipe::ReadEnd::close() { pipe_.closeRead(); }
+
+void InProcessPipe::ReadEnd::close(boost::system::error_code &ec) {
+  ec.clear();
+  pipe_.closeRead();
+}
+
+void InProcessPipe::ReadEnd::cancel() { pipe_.cancelRead(); }
+
+void InProcessPipe::ReadEnd::cancel(boost::system::error_code &ec) {
+  ec.clear();
+  pipe_.cancelRead();
+}
+
+bool InProcessPipe::WriteEnd::is_open() const {
+  const std::lock_guard<std::mutex> lk(pipe_.lock_);
+  return pipe_.writeOpen_;
+}
+
+void InProcessPipe::WriteEnd::close() { pipe_.closeWrite(); }
+
+void InProcessPipe::WriteEnd::close(boost::system::error_code &ec) {
+  ec.clear();
+  pipe_.closeWrite();
+}
+
+void InProcessPipe::WriteEnd::cancel() { pipe_.cancelWrite(); }
+
+void InProcessPipe::WriteEnd::cancel(boost::system::error_code &ec) {
+  ec.clear();
+  pipe_.cancelWrite();
+}
+
+InProcessPipe::InProcessPipe(boost::asio::io_service &ioService)
+    : ioService_(ioService), readEnd_(*this), writeEnd_(*this) {}
+
+void InProcessPipe::read(const boost::asio::mutable_buffer &buffer,
+                         const Handler &handler) {
+  const std::lock_guard<std::mutex> lk(lock_);
+  BOOST_ASSERT_MSG(!read_.handler, "Concurrent reads are not supported");
+  if (!readOpen_) {
+    post(handler, boost::asio::error::bad_descriptor, 0);
+  } else if (!boost::asio::buffer_size(buffer)) {
+    post(handler, boost::system::error_code(), 0);
+  } else {
+    read_.buffer = buffer;
+    read_.handler = handler;
+    if (write_.handler)
+      transfer();
+    else if (!writeOpen_)
+      complete(read_, boost::asio::error::eof, 0);
+  }
+}
+
+void InProcessPipe::write(const boost::asio::const_buffer &buffer,
+                          const Handler &handler) {
+  const std::lock_guard<std::mutex> lk(lock_);
+  BOOST_ASSERT_MSG(!write_.handler, "Concurrent writes are not supported");
+  if (!writeOpen_) {
+    post(handler, boost::asio::error::bad_descriptor, 0);
+  } else if (!readOpen_) {
+    post(handler, boost::asio::error::broken_pipe, 0);
+  } else if (!boost::asio::buffer_size(buffer)) {
+    post(handler, boost::system::error_code(), 0);
+  } else {
+    write_.buffer = buffer;
+    write_.handler = handler;
+    if (read_.handler) transfer();
+  }
+}
+
+void InProcessPipe::closeRead() {
+  const std::lock_guard<std::mutex> lk(lock_);
+  readOpen_ = false;
+  if (read_.handler) complete(read_, boost::asio::error::operation_aborted, 0);
+  if (write_.handler) complete(write_, boost::asio::error::broken_pipe, 0);
+}
+
+void InProcessPipe::closeWrite() {
+  const std::lock_guard<std::mutex> lk(lock_);
+  writeOpen_ = false;
+  if (write_.handler)
+    complete(write_, boost::asio::error::operation_aborted, 0);
+  if (read_.handler) complete(read_, boost::asio::error::eof, 0);
+}
+
+void InProcessPipe::cancelRead() {
+  const std::lock_guard<std::mutex> lk(lock_);
+  if (read_.handler) complete(read_, boost::asio::error::operation_aborted, 0);
+}
+
+void InProcessPipe::cancelWrite() {
+  const std::lock_guard<std::mutex> lk(lock_);
+  if (write_.handler)
+    complete(write_, boost::asio::error::operation_aborted, 0);
+}
+
+void InProcessPipe::transfer() {
+  const std::size_t size =
+      boost::asio::buffer_copy(read_.buffer, write_.buffer);
+  complete(read_, boost::system::error_code(), size);
+  complete(write_, boost::system::error_code(), size);
+}
+
+template <typename Buffer>
+void InProcessPipe::complete(Operation<Buffer> &operation,
+                             const boost::system::error_code &ec,
+                             const std::size_t size) {
+  Handler handler;
+  handler.swap(operation.handler);
+  post(handler, ec, size);
+}
+
+void InProcessPipe::post(const Handler &handler,
+                         const boost::system::error_code &ec,
+                         const std::size_t size) {
+  ioService_.post([handler, ec, size] { handler(ec, size); });
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
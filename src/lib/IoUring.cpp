@@ -0,0 +1,155 @@
+#include <yandex/contest/invoker/flowctl/interactive/IoUring.hpp>
+
+#include <yandex/contest/SystemError.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+int ioUringSetup(const unsigned entries, io_uring_params *const params) {
+  return ::syscall(__NR_io_uring_setup, entries, params);
+}
+
+int ioUringEnter(const int fd, const unsigned toSubmit,
+                 const unsigned minComplete, const unsigned flags) {
+  return ::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags,
+                   nullptr, 0);
+}
+
+int ioUringRegister(const int fd, const unsigned opcode, const void *const arg,
+                    const unsigned count) {
+  return ::syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+template <typename T>
+T *offset(void *const base, const unsigned offset) {
+  return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+}  // namespace
+
+bool IoUring::isSupported() {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  const int fd = ioUringSetup(1, &params);
+  if (fd < 0) return false;
+  ::close(fd);
+  return true;
+}
+
+IoUring::IoUring(const unsigned entries) {
+  std::memset(&params_, 0, sizeof(params_));
+  fd_ = ioUringSetup(entries, &params_);
+  if (fd_ < 0) BOOST_THROW_EXCEPTION(SystemError("io_uring_setup"));
+
+  sqRingSize_ = params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+  cqRingSize_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+  const bool singleMmap = params_.features & IORING_FEAT_SINGLE_MMAP;
+  if (singleMmap)
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+  sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+  if (sqRing_ == MAP_FAILED) {
+    ::close(fd_);
+    BOOST_THROW_EXCEPTION(SystemError("mmap"));
+  }
+
+  if (singleMmap) {
+    cqRing_ = sqRing_;
+  } else {
+    cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cqRing_ == MAP_FAILED) {
+      ::munmap(sqRing_, sqRingSize_);
+      ::close(fd_);
+      BOOST_THROW_EXCEPTION(SystemError("mmap"));
+    }
+  }
+
+  sqesSize_ = params_.sq_entries * sizeof(io_uring_sqe);
+  void *const sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    if (cqRing_ != sqRing_) ::munmap(cqRing_, cqRingSize_);
+    ::munmap(sqRing_, sqRingSize_);
+    ::close(fd_);
+    BOOST_THROW_EXCEPTION(SystemError("mmap"));
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  sqHead_ = offset<unsigned>(sqRing_, params_.sq_off.head);
+  sqTail_ = offset<unsigned>(sqRing_, params_.sq_off.tail);
+  sqMask_ = *offset<unsigned>(sqRing_, params_.sq_off.ring_mask);
+  sqArray_ = offset<unsigned>(sqRing_, params_.sq_off.array);
+  cqHead_ = offset<unsigned>(cqRing_, params_.cq_off.head);
+  cqTail_ = offset<unsigned>(cqRing_, params_.cq_off.tail);
+  cqMask_ = *offset<unsigned>(cqRing_, params_.cq_off.ring_mask);
+  cqes_ = offset<io_uring_cqe>(cqRing_, params_.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+  ::munmap(sqes_, sqesSize_);
+  if (cqRing_ != sqRing_) ::munmap(cqRing_, cqRingSize_);
+  ::munmap(sqRing_, sqRingSize_);
+  ::close(fd_);
+}
+
+io_uring_sqe *IoUring::getSqe() {
+  const unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+  if (sqeTail_ - head >= params_.sq_entries) return nullptr;
+  io_uring_sqe *const sqe = &sqes_[sqeTail_ & sqMask_];
+  ++sqeTail_;
+  std::memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+unsigned IoUring::submit() {
+  unsigned tail = *sqTail_;
+  const unsigned count = sqeTail_ - sqeHead_;
+  for (; sqeHead_ != sqeTail_; ++sqeHead_, ++tail)
+    sqArray_[tail & sqMask_] = sqeHead_ & sqMask_;
+  __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+  if (!count) return 0;
+
+  int submitted;
+  do {
+    submitted = ioUringEnter(fd_, count, 0, 0);
+  } while (submitted < 0 && errno == EINTR);
+  if (submitted < 0) BOOST_THROW_EXCEPTION(SystemError("io_uring_enter"));
+  return submitted;
+}
+
+bool IoUring::popCompletion(io_uring_cqe &cqe) {
+  const unsigned head = *cqHead_;
+  if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) return false;
+  cqe = cqes_[head & cqMask_];
+  __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+void IoUring::registerBuffers(const iovec *const buffers,
+                              const unsigned count) {
+  if (ioUringRegister(fd_, IORING_REGISTER_BUFFERS, buffers, count) < 0)
+    BOOST_THROW_EXCEPTION(SystemError("io_uring_register"));
+}
+
+void IoUring::registerEventFd(const int eventFd) {
+  if (ioUringRegister(fd_, IORING_REGISTER_EVENTFD, &eventFd, 1) < 0)
+    BOOST_THROW_EXCEPTION(SystemError("io_uring_register"));
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
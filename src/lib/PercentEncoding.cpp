@@ -0,0 +1,234 @@
+#include <yandex/contest/invoker/flowctl/interactive/PercentEncoding.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/CommandIo.hpp>
+
+#include <boost/assert.hpp>
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define YANDEX_CONTEST_PERCENT_ENCODING_X86
+#include <immintrin.h>
+#endif
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+struct Tables {
+  Tables() {
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+    for (unsigned c = 0; c < 256; ++c) {
+      permitted[c] = ('0' <= c && c <= '9') || ('a' <= c && c <= 'z') ||
+                     ('A' <= c && c <= 'Z') || c == '_';
+      escape[c][0] = '%';
+      escape[c][1] = HEX_DIGITS[c >> 4];
+      escape[c][2] = HEX_DIGITS[c & 0xF];
+      hex[c] = -1;
+    }
+    for (unsigned c = '0'; c <= '9'; ++c) hex[c] = c - '0';
+    for (unsigned c = 'a'; c <= 'f'; ++c) hex[c] = c - 'a' + 10;
+    for (unsigned c = 'A'; c <= 'F'; ++c) hex[c] = c - 'A' + 10;
+  }
+
+  std::array<bool, 256> permitted;
+  std::array<std::array<char, 3>, 256> escape;
+  std::array<int, 256> hex;
+};
+
+const Tables &tables() {
+  static const Tables tables;
+  return tables;
+}
+
+bool isPermitted(const char c) {
+  return tables().permitted[static_cast<unsigned char>(c)];
+}
+
+std::size_t permittedPrefixScalar(const char *const data,
+                                  const std::size_t size) {
+  std::size_t i = 0;
+  while (i < size && isPermitted(data[i])) ++i;
+  return i;
+}
+
+#ifdef YANDEX_CONTEST_PERCENT_ENCODING_X86
+/// Bytes >= 0x80 are negative and never match.
+__attribute__((target("sse2"))) unsigned permittedMaskSse2(const __m128i x) {
+  const __m128i digit =
+      _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('0' - 1)),
+                    _mm_cmplt_epi8(x, _mm_set1_epi8('9' + 1)));
+  // maps upper case letters to lower case ones,
+  // no other byte is mapped into [a-z]
+  const __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+  const __m128i alpha =
+      _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                    _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+  const __m128i underscore = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+  return _mm_movemask_epi8(
+      _mm_or_si128(_mm_or_si128(digit, alpha), underscore));
+}
+
+__attribute__((target("sse2"))) std::size_t permittedPrefixSse2(
+    const char *const data, const std::size_t size) {
+  constexpr std::size_t BLOCK = 16;
+  std::size_t i = 0;
+  for (; i + BLOCK <= size; i += BLOCK) {
+    const unsigned mask = permittedMaskSse2(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+    if (mask != 0xFFFF) return i + __builtin_ctz(~mask);
+  }
+  return i + permittedPrefixScalar(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) std::size_t permittedPrefixAvx2(
+    const char *const data, const std::size_t size) {
+  constexpr std::size_t BLOCK = 32;
+  std::size_t i = 0;
+  for (; i + BLOCK <= size; i += BLOCK) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    const __m256i digit =
+        _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('0' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), x));
+    const __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+    const __m256i alpha =
+        _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    const __m256i underscore = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'));
+    const unsigned mask = _mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_or_si256(digit, alpha), underscore));
+    if (mask != 0xFFFFFFFF) return i + __builtin_ctz(~mask);
+  }
+  return i + permittedPrefixSse2(data + i, size - i);
+}
+#endif
+}  // namespace
+
+PercentEncoding::Implementation PercentEncoding::bestImplementation() {
+  if (isSupported(Implementation::AVX2)) return Implementation::AVX2;
+  if (isSupported(Implementation::SSE2)) return Implementation::SSE2;
+  return Implementation::SCALAR;
+}
+
+bool PercentEncoding::isSupported(const Implementation implementation) {
+  switch (implementation) {
+    case Implementation::SCALAR:
+      return true;
+#ifdef YANDEX_CONTEST_PERCENT_ENCODING_X86
+    case Implementation::SSE2:
+      return __builtin_cpu_supports("sse2");
+    case Implementation::AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+const PercentEncoding &PercentEncoding::instance() {
+  static const PercentEncoding encoding;
+  return encoding;
+}
+
+int PercentEncoding::hexDigit(const char c) {
+  return tables().hex[static_cast<unsigned char>(c)];
+}
+
+PercentEncoding::PercentEncoding() : PercentEncoding(bestImplementation()) {}
+
+PercentEncoding::PercentEncoding(const Implementation implementation)
+    : implementation_(implementation),
+      permittedPrefix_(&permittedPrefixScalar) {
+  BOOST_ASSERT(isSupported(implementation_));
+#ifdef YANDEX_CONTEST_PERCENT_ENCODING_X86
+  switch (implementation_) {
+    case Implementation::SSE2:
+      permittedPrefix_ = &permittedPrefixSse2;
+      break;
+    case Implementation::AVX2:
+      permittedPrefix_ = &permittedPrefixAvx2;
+      break;
+    default:
+      break;
+  }
+#endif
+}
+
+std::size_t PercentEncoding::encode(const char *const data,
+                                    const std::size_t size,
+                                    char *const out) const {
+  std::size_t i = 0;
+  char *pos = out;
+  while (i < size) {
+    const std::size_t run = permittedPrefix_(data + i, size - i);
+    std::memcpy(pos, data + i, run);
+    pos += run;
+    i += run;
+    // escape the whole run of non-permitted bytes
+    while (i < size && !isPermitted(data[i])) {
+      const unsigned char c = data[i];
+      std::memcpy(pos, tables().escape[c].data(), 3);
+      pos += 3;
+      ++i;
+    }
+  }
+  return pos - out;
+}
+
+std::size_t PercentEncoding::decode(const char *const data,
+                                    const std::size_t size, char *const out,
+                                    std::size_t &outSize,
+                                    boost::system::error_code &ec) const {
+  ec.clear();
+  std::size_t i = 0;
+  char *pos = out;
+  while (i < size) {
+    const std::size_t run = permittedPrefix_(data + i, size - i);
+    std::memcpy(pos, data + i, run);
+    pos += run;
+    i += run;
+
+    while (i < size && data[i] == '%') {
+      if (size - i < 3) {
+        for (std::size_t j = i + 1; j < size; ++j) {
+          if (hexDigit(data[j]) < 0) {
+            ec = CommandIoErrc::DIGIT_EXPECTED;
+            outSize = pos - out;
+            return j;
+          }
+        }
+        ec = CommandIoErrc::INVALID_ESCAPE_SEQUENCE;
+        outSize = pos - out;
+        return size;
+      }
+      const int high = hexDigit(data[i + 1]);
+      const int low = hexDigit(data[i + 2]);
+      if (high < 0 || low < 0) {
+        ec = CommandIoErrc::DIGIT_EXPECTED;
+        outSize = pos - out;
+        return high < 0 ? i + 1 : i + 2;
+      }
+      *pos++ = static_cast<char>(high << 4 | low);
+      i += 3;
+    }
+
+    if (i < size && !isPermitted(data[i])) {
+      ec = CommandIoErrc::CHARACTER_IS_NOT_PERMITTED;
+      outSize = pos - out;
+      return i;
+    }
+  }
+  outSize = pos - out;
+  return i;
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,240 @@
+#include <yandex/contest/invoker/flowctl/interactive/RelayStatistics.hpp>
+
+#include <cctype>
+#include <string>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+void record(RelayStatistics::Histogram &histogram, std::uintmax_t value) {
+  std::size_t bucket = 0;
+  while (value && bucket + 1 < histogram.size()) {
+    value >>= 1;
+    ++bucket;
+  }
+  ++histogram[bucket];
+}
+
+boost::property_tree::ptree toPropertyTree(
+    const RelayStatistics::Histogram &histogram) {
+  boost::property_tree::ptree tree;
+  // bucket 0 is always kept, so empty histogram is still an array
+  const auto end = std::max(
+      histogram.begin() + 1,
+      std::find_if(histogram.rbegin(), histogram.rend(),
+                   [](const std::uintmax_t count) { return count; })
+          .base());
+  for (auto i = histogram.begin(); i != end; ++i) {
+    boost::property_tree::ptree bucket;
+    bucket.put_value(*i);
+    tree.push_back(std::make_pair("", bucket));
+  }
+  return tree;
+}
+
+/// Matches JSON number grammar.
+bool isNumber(const std::string &value) {
+  std::size_t i = 0;
+  const auto digits = [&value, &i] {
+    const std::size_t begin = i;
+    while (i < value.size() &&
+           std::isdigit(static_cast<unsigned char>(value[i])))
+      ++i;
+    return i - begin;
+  };
+  if (i < value.size() && value[i] == '-') ++i;
+  const std::size_t integer = digits();
+  if (!integer || (integer > 1 && value[i - integer] == '0')) return false;
+  if (i < value.size() && value[i] == '.') {
+    ++i;
+    if (!digits()) return false;
+  }
+  if (i < value.size() && (value[i] == 'e' || value[i] == 'E')) {
+    ++i;
+    if (i < value.size() && (value[i] == '+' || value[i] == '-')) ++i;
+    if (!digits()) return false;
+  }
+  return i == value.size();
+}
+
+void writeString(std::ostream &out, const std::string &value) {
+  out << '"';
+  for (const char c : value) {
+    switch (c) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      case '\t':
+        out << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          static const char hex[] = "0123456789abcdef";
+          out << "\\u00" << hex[(c >> 4) & 0xF] << hex[c & 0xF];
+        } else {
+          out << c;
+        }
+    }
+  }
+  out << '"';
+}
+
+void writeJson(std::ostream &out, const boost::property_tree::ptree &tree,
+               const std::size_t indent) {
+  if (tree.empty()) {
+    if (isNumber(tree.data()))
+      out << tree.data();
+    else
+      writeString(out, tree.data());
+    return;
+  }
+
+  const bool array =
+      std::all_of(tree.begin(), tree.end(),
+                  [](const boost::property_tree::ptree::value_type &child) {
+                    return child.first.empty();
+                  });
+  out << (array ? '[' : '{');
+  for (auto i = tree.begin(); i != tree.end(); ++i) {
+    if (i != tree.begin()) out << ',';
+    out << '\n' << std::string(indent + 2, ' ');
+    if (!array) {
+      writeString(out, i->first);
+      out << ": ";
+    }
+    writeJson(out, i->second, indent + 2);
+  }
+  out << '\n' << std::string(indent, ' ') << (array ? ']' : '}');
+}
+}  // namespace
+
+void RelayMonitor::read(const std::size_t size) {
+  if (!size) return;
+  ++statistics_.reads;
+  statistics_.bytesRead += size;
+  record(statistics_.chunkSize, size);
+  pending_.emplace_back(statistics_.bytesRead, Clock::now());
+  statistics_.maxBacklog =
+      std::max(statistics_.maxBacklog,
+               statistics_.bytesRead - statistics_.bytesWritten);
+}
+
+void RelayMonitor::write(const std::size_t size) {
+  if (!size) return;
+  ++statistics_.writes;
+  statistics_.bytesWritten += size;
+  if (pending_.empty() || pending_.front().first > statistics_.bytesWritten)
+    return;
+
+  const Clock::time_point now = Clock::now();
+  while (!pending_.empty() &&
+         pending_.front().first <= statistics_.bytesWritten) {
+    record(statistics_.latency,
+           std::chrono::duration_cast<std::chrono::microseconds>(
+               now - pending_.front().second)
+               .count());
+    pending_.pop_front();
+  }
+}
+
+void ThinkTimeMonitor::interactorRead() {
+  endTurn(Turn::INTERACTOR, thinkTime_.interactor, thinkTime_.interactorTurns);
+}
+
+void ThinkTimeMonitor::interactorWritten() { beginTurn(Turn::INTERACTOR); }
+
+void ThinkTimeMonitor::solutionRead() {
+  endTurn(Turn::SOLUTION, thinkTime_.solution, thinkTime_.solutionTurns);
+}
+
+void ThinkTimeMonitor::solutionWritten() { beginTurn(Turn::SOLUTION); }
+
+void ThinkTimeMonitor::endTurn(const Turn turn, std::chrono::nanoseconds &time,
+                               std::uintmax_t &turns) {
+  if (turn_ != turn) return;
+  time += Clock::now() - turnBegin_;
+  ++turns;
+  turn_ = Turn::NONE;
+}
+
+void ThinkTimeMonitor::beginTurn(const Turn turn) {
+  // turn lasts since the last chunk was delivered
+  turn_ = turn;
+  turnBegin_ = Clock::now();
+}
+
+std::ostream &operator<<(std::ostream &out, const ThinkTime &thinkTime) {
+  using Milliseconds = std::chrono::milliseconds;
+  return out << "interactor "
+             << std::chrono::duration_cast<Milliseconds>(thinkTime.interactor)
+                    .count()
+             << " ms in " << thinkTime.interactorTurns << " turns, solution "
+             << std::chrono::duration_cast<Milliseconds>(thinkTime.solution)
+                    .count()
+             << " ms in " << thinkTime.solutionTurns << " turns, "
+             << thinkTime.roundTrips() << " round trips";
+}
+
+boost::property_tree::ptree toPropertyTree(
+    const RelayStatistics &statistics) {
+  boost::property_tree::ptree tree;
+  tree.put("bytesRead", statistics.bytesRead);
+  tree.put("bytesWritten", statistics.bytesWritten);
+  tree.put("reads", statistics.reads);
+  tree.put("writes", statistics.writes);
+  tree.put("maxBacklog", statistics.maxBacklog);
+  tree.put_child("chunkSize", toPropertyTree(statistics.chunkSize));
+  tree.put_child("latency", toPropertyTree(statistics.latency));
+  return tree;
+}
+
+boost::property_tree::ptree toPropertyTree(const ThinkTime &thinkTime) {
+  using Microseconds = std::chrono::microseconds;
+  boost::property_tree::ptree tree;
+  tree.put("interactor",
+           std::chrono::duration_cast<Microseconds>(thinkTime.interactor)
+               .count());
+  tree.put("solution",
+           std::chrono::duration_cast<Microseconds>(thinkTime.solution)
+               .count());
+  tree.put("interactorTurns", thinkTime.interactorTurns);
+  tree.put("solutionTurns", thinkTime.solutionTurns);
+  tree.put("roundTrips", thinkTime.roundTrips());
+  return tree;
+}
+
+boost::property_tree::ptree toPropertyTree(
+    const SessionStatistics &statistics) {
+  boost::property_tree::ptree tree;
+  tree.put_child("interactorToSolution",
+                 toPropertyTree(statistics.interactorToSolution));
+  tree.put_child("solutionToInteractor",
+                 toPropertyTree(statistics.solutionToInteractor));
+  tree.put_child("thinkTime", toPropertyTree(statistics.thinkTime));
+  if (statistics.userTime)
+    tree.put("userTime", statistics.userTime->count());
+  if (statistics.systemTime)
+    tree.put("systemTime", statistics.systemTime->count());
+  return tree;
+}
+
+void writeJson(std::ostream &out, const boost::property_tree::ptree &tree) {
+  writeJson(out, tree, 0);
+  out << '\n';
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <yandex/contest/invoker/flowctl/interactive/Relay.hpp>
+
+#include <yandex/contest/SystemError.hpp>
+#include <yandex/contest/system/unistd/Descriptor.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+// Helpers shared by library sources, not installed.
+
+/// errno of the last failed system call.
+inline boost::system::error_code lastError() {
+  return boost::system::error_code(errno, boost::system::system_category());
+}
+
+/// Pass the first size bytes of parts to handler, one call per part.
+inline void callDataHandler(const Relay::DataHandler &handler,
+                            const iovec *parts, std::size_t size) {
+  for (; size; ++parts) {
+    const std::size_t part = std::min(parts->iov_len, size);
+    handler(static_cast<const char *>(parts->iov_base), part);
+    size -= part;
+  }
+}
+
+/// Create or truncate dump or statistics file.
+inline system::unistd::Descriptor openOutputFile(
+    const boost::filesystem::path &path) {
+  const int file =
+      ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (file < 0)
+    BOOST_THROW_EXCEPTION(SystemError("open")
+                          << bunsan::error::message(path.string()));
+  return system::unistd::Descriptor(file);
+}
+
+/// Write whole buffer to blocking file.
+inline void writeAll(const int file, const char *data, std::size_t size) {
+  while (size) {
+    const ssize_t written = ::write(file, data, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      BOOST_THROW_EXCEPTION(SystemError("write"));
+    }
+    data += written;
+    size -= written;
+  }
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,381 @@
+#include <yandex/contest/invoker/flowctl/interactive/SimpleBrokerSession.hpp>
+
+#include "RelayUtility.hpp"
+
+#include <yandex/contest/StreamLog.hpp>
+#include <yandex/contest/SystemError.hpp>
+
+#include <boost/io/detail/quoted_manip.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <sstream>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+int useFd(const char *const name, const int fd) {
+  STREAM_INFO << "Using " << fd << " as " << name << " file descriptor";
+  return fd;
+}
+
+std::chrono::microseconds toDuration(const timeval &time) {
+  return std::chrono::seconds(time.tv_sec) +
+         std::chrono::microseconds(time.tv_usec);
+}
+
+/// Resource usage of the whole broker process.
+rusage getResourceUsage() {
+  rusage usage;
+  if (::getrusage(RUSAGE_SELF, &usage) < 0)
+    BOOST_THROW_EXCEPTION(SystemError("getrusage"));
+  return usage;
+}
+}  // namespace
+
+SimpleBrokerSession::SimpleBrokerSession(boost::asio::io_service &ioService,
+                                         const SimpleBroker::Options &options)
+    : ioService_(ioService),
+      options_(options),
+      solutionSource_(ioService,
+                      useFd("solution source", options_.solutionSourceFd)),
+      solutionSink_(ioService, useFd("solution sink", options_.solutionSinkFd)),
+      interactorSource_(
+          ioService, useFd("interactor source", options_.interactorSourceFd)),
+      interactorSink_(ioService,
+                      useFd("interactor sink", options_.interactorSinkFd)),
+      connection_(interactorSource_, interactorSink_, solutionSource_,
+                  solutionSink_, options_.outputLimitBytes),
+      notifier_(ioService, useFd("notifier", options_.notifierFd)),
+      interactorTerminationTimer_(ioService),
+      solutionTerminationTimer_(ioService),
+      completionTimer_(ioService) {
+  STREAM_INFO << "Using " << options_.relayMode << " relay mode";
+  connection_.setRelayMode(options_.relayMode);
+  connection_.setRelayBufferSize(options_.relayBufferSize);
+  connection_.setMaxRelayBufferSize(options_.maxRelayBufferSize);
+
+  if (options_.interactorCoalescing)
+    connection_.setInteractorCoalescing(*options_.interactorCoalescing);
+  if (options_.solutionCoalescing)
+    connection_.setSolutionCoalescing(*options_.solutionCoalescing);
+
+  if (options_.pipeCapacity) {
+    STREAM_INFO << "Requesting " << options_.pipeCapacity
+                << " bytes pipe capacity";
+    connection_.setPipeCapacity(options_.pipeCapacity);
+  }
+
+  if (options_.dumpJudge) {
+    STREAM_INFO << "Dumping judge's output into " << *options_.dumpJudge;
+    if (options_.dumpJudgeFd >= 0) {
+      connection_.setDumpJudge(
+          *options_.dumpJudge,
+          system::unistd::Descriptor(
+              useFd("judge's dump", options_.dumpJudgeFd)));
+    } else {
+      connection_.setDumpJudge(*options_.dumpJudge);
+    }
+  }
+
+  if (options_.dumpSolution) {
+    STREAM_INFO << "Dumping solution's output into " << *options_.dumpSolution;
+    if (options_.dumpSolutionFd >= 0) {
+      connection_.setDumpSolution(
+          *options_.dumpSolution,
+          system::unistd::Descriptor(
+              useFd("solution's dump", options_.dumpSolutionFd)));
+    } else {
+      connection_.setDumpSolution(*options_.dumpSolution);
+    }
+  }
+
+  if (options_.asyncDump) {
+    STREAM_INFO << "Dumping asynchronously using "
+                << options_.asyncDump->bufferSize << " bytes buffer, "
+                << options_.asyncDump->overflowPolicy << " on overflow, "
+                << "waiting at most " << options_.asyncDump->maxStall.count()
+                << " ms";
+    connection_.setAsyncDump(*options_.asyncDump);
+  }
+
+  if (options_.statistics) {
+    STREAM_INFO << "Writing statistics into " << *options_.statistics;
+    if (options_.statisticsFd >= 0) {
+      statisticsFile_ = system::unistd::Descriptor(
+          useFd("statistics", options_.statisticsFd));
+    }
+    connection_.enableStatistics();
+  }
+}
+
+void SimpleBrokerSession::start(const Handler &handler) {
+  handler_ = handler;
+  if (options_.statistics && measureResourceUsage_)
+    startUsage_ = getResourceUsage();
+
+  notifier_.onError([this](const Notifier::Error::Event &event) {
+    if (event.errorCode == boost::asio::error::operation_aborted) {
+      STREAM_INFO << "Notification was canceled";
+      return;
+    }
+
+    STREAM_ERROR << "Notification failure: " << event.errorCode.message();
+    result(SimpleBroker::FAILED);
+  });
+
+  notifier_.onSpawn([](const Notifier::Spawn::Event &event) {
+    STREAM_INFO << event.meta.name << ":" << event.meta.id << " has spawned";
+  });
+
+  notifier_.onTermination([this](const Notifier::Termination::Event &event) {
+    STREAM_INFO << boost::io::quoted(event.meta.name) << " has terminated";
+    if (event.meta.name == "interactor")
+      handle_interactor_termination(event.result);
+    else if (event.meta.name == "solution")
+      handle_solution_termination(event.result);
+  });
+
+  connection_.interactorEof.connect([this] { handle_interactor_eof(); });
+  connection_.solutionEof.connect([this] { handle_solution_eof(); });
+
+  connection_.interactorOutputLimitExceeded.connect(
+      [this] { result(SimpleBroker::INTERACTOR_OUTPUT_LIMIT_EXCEEDED); });
+
+  connection_.solutionOutputLimitExceeded.connect(
+      [this] { result(SimpleBroker::SOLUTION_OUTPUT_LIMIT_EXCEEDED); });
+
+  connection_.interactorReadError.connect(
+      [this](const boost::system::error_code &ec, const std::size_t /*size*/) {
+        STREAM_ERROR << "Interactor read failure: " << ec.message();
+        result(SimpleBroker::FAILED);
+      });
+
+  connection_.interactorWriteError.connect(
+      [this](const boost::system::error_code &ec, const std::size_t /*size*/) {
+        handle_interactor_write_error(ec);
+      });
+
+  connection_.solutionReadError.connect(
+      [this](const boost::system::error_code &ec, const std::size_t /*size*/) {
+        STREAM_ERROR << "Solution read failure: " << ec.message();
+        result(SimpleBroker::FAILED);
+      });
+
+  connection_.solutionWriteError.connect(
+      [](const boost::system::error_code &ec, const std::size_t /*size*/) {
+        STREAM_INFO << "Solution write failure: " << ec.message();
+      });
+
+  connection_.dumpError.connect([this](const std::exception_ptr error) {
+    if (!error_) error_ = error;
+    result(SimpleBroker::FAILED);
+  });
+
+  STREAM_INFO << "Starting connection";
+  connection_.start();
+
+  STREAM_INFO << "Starting notifier";
+  notifier_.start();
+
+  // released on completion
+  self_ = shared_from_this();
+}
+
+void SimpleBrokerSession::fail(const std::exception_ptr error) {
+  if (!error_) error_ = error;
+  result(SimpleBroker::FAILED);
+  complete();
+}
+
+void SimpleBrokerSession::result(const Status status) {
+  if (status_) return;
+  notifier_.close();
+  status_ = status;
+  STREAM_INFO << "Session status = " << status;
+
+  if (interactorEof_ && solutionEof_) {
+    complete();
+    return;
+  }
+
+  const auto self = shared_from_this();
+  completionTimer_.expires_from_now(options_.terminationRealTimeLimit);
+  completionTimer_.async_wait(
+      [this, self](const boost::system::error_code &ec) {
+        if (ec == boost::asio::error::operation_aborted) return;
+        STREAM_INFO << "Connection is still active, terminating";
+        complete();
+      });
+}
+
+void SimpleBrokerSession::complete() {
+  if (completed_) return;
+  completed_ = true;
+
+  interactorTerminationTimer_.cancel();
+  solutionTerminationTimer_.cancel();
+  completionTimer_.cancel();
+  connection_.terminate();
+
+  // Canceled operations are already queued, so handler is called
+  // and session is destroyed after they have completed.
+  const auto self = shared_from_this();
+  ioService_.post([this, self] {
+    try {
+      connection_.flushDumps();
+    } catch (std::exception &e) {
+      STREAM_ERROR << "Unable to flush dumps: " << e.what();
+    }
+    if (const auto statistics = connection_.judgeDumpStatistics())
+      STREAM_INFO << "Judge's dump: " << *statistics;
+    if (const auto statistics = connection_.solutionDumpStatistics())
+      STREAM_INFO << "Solution's dump: " << *statistics;
+
+    if (*status_ == SimpleBroker::OK) {
+      BOOST_ASSERT(interactorResult_);
+      BOOST_ASSERT(solutionResult_);
+    }
+
+    if (options_.statistics) {
+      try {
+        writeStatistics();
+      } catch (std::exception &e) {
+        STREAM_ERROR << "Unable to write statistics: " << e.what();
+      }
+    }
+
+    STREAM_INFO << "Think time: " << connection_.thinkTime();
+    STREAM_INFO << "Completed with status = " << *status_;
+    const Handler handler = std::move(handler_);
+    self_.reset();
+    handler(*status_);
+  });
+}
+
+void SimpleBrokerSession::writeStatistics() {
+  SessionStatistics statistics;
+  if (const auto relay = connection_.interactorToSolutionStatistics())
+    statistics.interactorToSolution = *relay;
+  if (const auto relay = connection_.solutionToInteractorStatistics())
+    statistics.solutionToInteractor = *relay;
+  statistics.thinkTime = connection_.thinkTime();
+
+  if (measureResourceUsage_) {
+    const rusage usage = getResourceUsage();
+    statistics.userTime =
+        toDuration(usage.ru_utime) - toDuration(startUsage_.ru_utime);
+    statistics.systemTime =
+        toDuration(usage.ru_stime) - toDuration(startUsage_.ru_stime);
+  }
+
+  boost::property_tree::ptree tree = toPropertyTree(statistics);
+  tree.put("status", boost::lexical_cast<std::string>(*status_));
+
+  std::ostringstream json;
+  writeJson(json, tree);
+  const std::string data = json.str();
+
+  system::unistd::Descriptor file = statisticsFile_
+                                        ? std::move(statisticsFile_)
+                                        : openOutputFile(*options_.statistics);
+  writeAll(file.get(), data.data(), data.size());
+  file.close();
+}
+
+void SimpleBrokerSession::waitForInteractorTermination() {
+  STREAM_INFO << "Waiting for interactor's termination...";
+  interactorTerminationTimer_.async_wait(
+      options_.terminationRealTimeLimit,
+      [this](const boost::system::error_code &ec) {
+        if (ec == boost::asio::error::operation_aborted) return;
+        result(SimpleBroker::INTERACTOR_TERMINATION_REAL_TIME_LIMIT_EXCEEDED);
+      });
+}
+
+void SimpleBrokerSession::waitForSolutionTermination() {
+  STREAM_INFO << "Waiting for solution's termination";
+  solutionTerminationTimer_.async_wait(
+      options_.terminationRealTimeLimit,
+      [this](const boost::system::error_code &ec) {
+        if (ec == boost::asio::error::operation_aborted) return;
+        result(SimpleBroker::SOLUTION_TERMINATION_REAL_TIME_LIMIT_EXCEEDED);
+      });
+}
+
+void SimpleBrokerSession::handle_interactor_eof() {
+  interactorEof_ = true;
+  if (status_) {
+    if (solutionEof_) complete();
+    return;
+  }
+  waitForInteractorTermination();
+}
+
+void SimpleBrokerSession::handle_solution_eof() {
+  solutionEof_ = true;
+  if (status_) {
+    if (interactorEof_) complete();
+    return;
+  }
+  waitForSolutionTermination();
+}
+
+void SimpleBrokerSession::handle_interactor_termination(
+    const process::Result &processResult) {
+  BOOST_ASSERT(!interactorResult_);
+  interactorResult_ = processResult;
+  interactorTerminationTimer_.cancel();
+  if (processResult) {
+    STREAM_INFO << "Interactor has terminated OK";
+    if (solutionExcessData_) {
+      result(SimpleBroker::SOLUTION_EXCESS_DATA);
+      return;
+    }
+    STREAM_INFO << "Closing solution's STDIN";
+    connection_.closeInteractorToSolution();
+  } else if (processResult.exitStatus) {
+    STREAM_INFO << "Interactor has terminated not OK, "
+                << "solution's STDIN left intact";
+  } else {
+    STREAM_INFO << "Interactor has failed to exit";
+    result(SimpleBroker::FAILED);
+    return;
+  }
+  waitForSolutionTermination();
+
+  if (solutionResult_) result(SimpleBroker::OK);
+}
+
+void SimpleBrokerSession::handle_solution_termination(
+    const process::Result &processResult) {
+  BOOST_ASSERT(!solutionResult_);
+  solutionResult_ = processResult;
+  solutionTerminationTimer_.cancel();
+
+  if (interactorResult_) result(SimpleBroker::OK);
+}
+
+void SimpleBrokerSession::handle_interactor_write_error(
+    const boost::system::error_code &ec) {
+  STREAM_ERROR << "Interactor write failure: " << ec.message();
+  if (ec == boost::asio::error::broken_pipe) {
+    if (interactorResult_) {
+      if (*interactorResult_) result(SimpleBroker::SOLUTION_EXCESS_DATA);
+    } else {
+      solutionExcessData_ = true;
+      waitForInteractorTermination();
+    }
+  } else {
+    result(SimpleBroker::FAILED);
+  }
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,125 @@
+#include <yandex/contest/invoker/flowctl/interactive/SpliceDump.hpp>
+
+#include "RelayUtility.hpp"
+
+#include <yandex/contest/invoker/flowctl/interactive/AsyncDump.hpp>
+
+#include <yandex/contest/StreamLog.hpp>
+#include <yandex/contest/SystemError.hpp>
+#include <yandex/contest/system/unistd/Pipe.hpp>
+
+#include <vector>
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+constexpr int PIPE_CAPACITY = 1024 * 1024;
+constexpr std::size_t CHUNK_SIZE = 1024 * 1024;
+}  // namespace
+
+SpliceDump::SpliceDump(boost::asio::io_service &ioService,
+                       const boost::filesystem::path &path)
+    : SpliceDump(ioService, openOutputFile(path)) {}
+
+SpliceDump::SpliceDump(boost::asio::io_service &ioService,
+                       system::unistd::Descriptor file)
+    : sink_(ioService), file_(std::move(file)) {
+  system::unistd::Pipe pipe;
+  source_ = pipe.releaseReadEnd();
+  sink_.assign(pipe.releaseWriteEnd().release());
+
+  // best effort, absorbs bursts while the file is being written
+  ::fcntl(sink_.native_handle(), F_SETPIPE_SZ, PIPE_CAPACITY);
+
+  thread_ = std::thread(&SpliceDump::run, this);
+}
+
+SpliceDump::~SpliceDump() {
+  close();
+  if (thread_.joinable()) thread_.join();
+}
+
+void SpliceDump::close() {
+  boost::system::error_code ec;
+  sink_.close(ec);
+}
+
+void SpliceDump::run() {
+  for (;;) {
+    const ssize_t size = ::splice(source_.get(), nullptr, file_.get(), nullptr,
+                                  CHUNK_SIZE, SPLICE_F_MOVE | SPLICE_F_MORE);
+    if (size > 0) continue;
+    if (!size) break;
+    if (errno == EINTR) continue;
+    if (errno == EINVAL) {
+      // file system does not support splice
+      if (!copy()) return;
+      break;
+    }
+    STREAM_ERROR << "Unable to write dump: "
+                 << boost::system::error_code(errno,
+                                              boost::system::system_category())
+                        .message();
+    drain();
+    return;
+  }
+
+  // sink is closed, so relay has finished marking
+  if (truncated_) {
+    try {
+      writeAll(file_.get(), AsyncDump::TRUNCATION_MARKER,
+               std::strlen(AsyncDump::TRUNCATION_MARKER));
+    } catch (std::exception &e) {
+      STREAM_ERROR << "Unable to write dump: " << e.what();
+    }
+  }
+}
+
+bool SpliceDump::copy() {
+  std::vector<char> buffer(CHUNK_SIZE);
+  for (;;) {
+    const ssize_t size = ::read(source_.get(), buffer.data(), buffer.size());
+    if (size < 0 && errno == EINTR) continue;
+    if (size < 0) return false;
+    if (!size) return true;
+    for (ssize_t written = 0; written < size;) {
+      const ssize_t part =
+          ::write(file_.get(), buffer.data() + written, size - written);
+      if (part < 0 && errno == EINTR) continue;
+      if (part < 0) {
+        STREAM_ERROR << "Unable to write dump: "
+                     << boost::system::error_code(
+                            errno, boost::system::system_category())
+                            .message();
+        drain();
+        return false;
+      }
+      written += part;
+    }
+  }
+}
+
+void SpliceDump::drain() {
+  // relay must never block on a broken dump
+  char buffer[BUFSIZ];
+  for (;;) {
+    const ssize_t size = ::read(source_.get(), buffer, sizeof(buffer));
+    if (size < 0 && errno == EINTR) continue;
+    if (size <= 0) return;
+  }
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
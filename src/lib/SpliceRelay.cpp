@@ -0,0 +1,369 @@
+#include <yandex/contest/invoker/flowctl/interactive/SpliceRelay.hpp>
+
+#include "RelayUtility.hpp"
+
+#include <yandex/contest/StreamLog.hpp>
+#include <yandex/contest/system/unistd/Pipe.hpp>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+constexpr std::size_t DEFAULT_PIPE_CAPACITY = 64 * 1024;
+
+/// Longest time finish() waits for dump.
+constexpr std::chrono::milliseconds DUMP_FLUSH_TIMEOUT(100);
+
+bool isSpliceable(const int fd) {
+  struct stat st;
+  if (::fstat(fd, &st) < 0) return false;
+  return S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode);
+}
+
+bool isPipe(const int fd) {
+  struct stat st;
+  if (::fstat(fd, &st) < 0) return false;
+  return S_ISFIFO(st.st_mode);
+}
+}  // namespace
+
+SpliceRelay::SpliceRelay(Connection &source, Connection &sink,
+                         const Handler &readHandler,
+                         const Handler &writeHandler)
+    : source_(source),
+      sink_(sink),
+      readHandler_(readHandler),
+      writeHandler_(writeHandler) {
+  system::unistd::Pipe pipe;
+  pipeReadEnd_ = pipe.releaseReadEnd();
+  pipeWriteEnd_ = pipe.releaseWriteEnd();
+
+  const int capacity = ::fcntl(pipeWriteEnd_.get(), F_GETPIPE_SZ);
+  capacity_ = capacity > 0 ? capacity : DEFAULT_PIPE_CAPACITY;
+}
+
+std::size_t SpliceRelay::setCapacity(const std::size_t capacity) {
+  const int applied =
+      ::fcntl(pipeWriteEnd_.get(), F_SETPIPE_SZ, static_cast<int>(capacity));
+  if (applied < 0) {
+    STREAM_WARNING << "Unable to set splice pipe capacity to " << capacity
+                   << ": " << lastError().message();
+  } else {
+    capacity_ = applied;
+  }
+  return capacity_;
+}
+
+bool SpliceRelay::isSupported(Connection &source, Connection &sink,
+                              const bool writeDump) {
+  return isSpliceable(source.native_handle()) &&
+         isSpliceable(sink.native_handle()) &&
+         (!writeDump || isPipe(sink.native_handle()));
+}
+
+void SpliceRelay::setReadDump(SpliceDump &dump) {
+  dump_ = &dump;
+  dumpWritten_ = false;
+}
+
+void SpliceRelay::setWriteDump(SpliceDump &dump) {
+  dump_ = &dump;
+  dumpWritten_ = true;
+}
+
+void SpliceRelay::setCloseSinkOnEof(const bool closeSinkOnEof) {
+  closeSinkOnEof_ = closeSinkOnEof;
+}
+
+void SpliceRelay::setDiscardOnSinkError(const bool discardOnSinkError) {
+  discardOnSinkError_ = discardOnSinkError;
+}
+
+void SpliceRelay::start() {
+  source_.non_blocking(true);
+  sink_.non_blocking(true);
+  read();
+}
+
+void SpliceRelay::close() {
+  closing_ = true;
+  if (!pending_) finish();
+}
+
+void SpliceRelay::terminate() { finish(); }
+
+void SpliceRelay::read() {
+  if (finished_ || closing_) return;
+  source_.async_read_some(
+      boost::asio::null_buffers(),
+      boost::bind(&SpliceRelay::handle_source_ready, this,
+                  boost::asio::placeholders::error));
+}
+
+void SpliceRelay::handle_source_ready(const boost::system::error_code &ec) {
+  if (finished_ || closing_ || ec == boost::asio::error::operation_aborted)
+    return;
+
+  if (ec) {
+    readHandler_(ec, 0);
+    finish();
+    return;
+  }
+
+  const ssize_t size =
+      ::splice(source_.native_handle(), nullptr, pipeWriteEnd_.get(), nullptr,
+               capacity_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (size < 0) {
+    if (errno == EAGAIN || errno == EINTR) {
+      read();
+    } else {
+      readHandler_(lastError(), 0);
+      finish();
+    }
+    return;
+  }
+
+  if (!size) {
+    eof_ = true;
+    readHandler_(boost::asio::error::eof, 0);
+    if (closeSinkOnEof_) finish();
+    return;
+  }
+
+  pending_ = size;
+  readHandler_(boost::system::error_code(), size);
+  if (finished_) return;
+
+  write();
+}
+
+void SpliceRelay::write() {
+  while (pending_) {
+    if (!owed_ && !tee()) return;
+    if (!flush()) return;
+  }
+
+  if (closing_) {
+    finish();
+  } else {
+    read();
+  }
+}
+
+bool SpliceRelay::tee() {
+  if (!dump_) {
+    owedTarget_ = sinkFailed_ ? NONE : SINK;
+    owed_ = pending_;
+    return true;
+  }
+
+  if (sinkFailed_) {
+    owedTarget_ = dumpWritten_ ? NONE : DUMP;
+    owed_ = pending_;
+    return true;
+  }
+
+  Connection &target = dumpWritten_ ? sink_ : dump_->sink();
+  ssize_t size;
+  do {
+    size = ::tee(pipeReadEnd_.get(), target.native_handle(), pending_,
+                 SPLICE_F_NONBLOCK);
+  } while (size < 0 && errno == EINTR);
+
+  if (size < 0) {
+    if (errno == EAGAIN) {
+      wait(target);
+    } else if (dumpWritten_) {
+      handle_sink_error(lastError());
+    } else {
+      dumpFailed(lastError());
+      return tee();
+    }
+    return false;
+  }
+
+  owed_ = size;
+  if (dumpWritten_) {
+    owedTarget_ = DUMP;
+    writeHandler_(boost::system::error_code(), size);
+    return !finished_;
+  }
+  owedTarget_ = SINK;
+  return true;
+}
+
+bool SpliceRelay::flush() {
+  while (owed_) {
+    if (owedTarget_ == NONE) {
+      drain(owed_);
+      continue;
+    }
+
+    Connection &target = owedTarget_ == SINK ? sink_ : dump_->sink();
+    const ssize_t size =
+        ::splice(pipeReadEnd_.get(), nullptr, target.native_handle(), nullptr,
+                 owed_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (size < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) {
+        wait(target);
+        return false;
+      }
+      if (owedTarget_ == SINK) {
+        handle_sink_error(lastError());
+        return false;
+      }
+      dumpFailed(lastError());
+      continue;
+    }
+
+    pending_ -= size;
+    owed_ -= size;
+    if (owedTarget_ == SINK) {
+      writeHandler_(boost::system::error_code(), size);
+      if (finished_) return false;
+    }
+  }
+  return true;
+}
+
+void SpliceRelay::wait(Connection &connection) {
+  if (&connection == &sink_) {
+    sink_.async_write_some(
+        boost::asio::null_buffers(),
+        boost::bind(&SpliceRelay::handle_sink_ready, this,
+                    boost::asio::placeholders::error));
+  } else {
+    connection.async_write_some(
+        boost::asio::null_buffers(),
+        boost::bind(&SpliceRelay::handle_dump_ready, this,
+                    boost::asio::placeholders::error));
+  }
+}
+
+void SpliceRelay::handle_sink_ready(const boost::system::error_code &ec) {
+  if (finished_ || ec == boost::asio::error::operation_aborted) return;
+
+  if (ec) {
+    handle_sink_error(ec);
+  } else {
+    write();
+  }
+}
+
+void SpliceRelay::handle_dump_ready(const boost::system::error_code &ec) {
+  if (finished_ || ec == boost::asio::error::operation_aborted) return;
+  write();
+}
+
+void SpliceRelay::handle_sink_error(const boost::system::error_code &ec) {
+  sinkFailed_ = true;
+  // either already dumped or not dumped at all
+  if (owedTarget_ == SINK) owedTarget_ = NONE;
+
+  writeHandler_(ec, 0);
+  if (finished_) return;
+
+  if (discardOnSinkError_) {
+    write();
+  } else {
+    finish();
+  }
+}
+
+void SpliceRelay::dumpFailed(const boost::system::error_code &ec) {
+  STREAM_ERROR << "Unable to dump data: " << ec.message();
+  dump_->close();
+  dump_ = nullptr;
+  if (owedTarget_ == DUMP) owedTarget_ = NONE;
+}
+
+void SpliceRelay::drain(const std::size_t size) {
+  char buffer[BUFSIZ];
+  std::size_t left = size;
+  while (left) {
+    const ssize_t part =
+        ::read(pipeReadEnd_.get(), buffer, std::min(left, sizeof(buffer)));
+    if (part < 0 && errno == EINTR) continue;
+    if (part <= 0) break;
+    left -= part;
+  }
+  pending_ -= size;
+  owed_ -= std::min(owed_, size);
+}
+
+void SpliceRelay::flushDump() {
+  if (!dump_) return;
+
+  // Execution loop is leaving, so remaining data is moved synchronously,
+  // dump which is not drained in time is truncated.
+  const auto deadline = std::chrono::steady_clock::now() + DUMP_FLUSH_TIMEOUT;
+  bool truncated = false;
+  const auto spliceToDump = [this, deadline, &truncated](
+                                const std::size_t size) {
+    const int fd = dump_->sink().native_handle();
+    std::size_t left = size;
+    while (left && !truncated) {
+      const ssize_t part = ::splice(pipeReadEnd_.get(), nullptr, fd, nullptr,
+                                    left, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (part < 0) {
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) break;
+        const auto timeout =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+        pollfd pfd = {fd, POLLOUT, 0};
+        if (timeout.count() <= 0 || !::poll(&pfd, 1, timeout.count()))
+          truncated = true;
+        continue;
+      }
+      left -= part;
+    }
+    pending_ -= size;
+  };
+
+  if (owedTarget_ == DUMP) {
+    spliceToDump(owed_);
+    owed_ = 0;
+  } else {
+    drain(owed_);
+  }
+  if (!dumpWritten_) spliceToDump(pending_);
+
+  if (truncated) {
+    STREAM_WARNING << "Dump is not drained in "
+                   << DUMP_FLUSH_TIMEOUT.count() << " ms, truncating dump";
+    dump_->markTruncated();
+  }
+  dump_->close();
+}
+
+void SpliceRelay::finish() {
+  if (finished_) return;
+  finished_ = true;
+
+  flushDump();
+
+  boost::system::error_code ec;
+  source_.close(ec);
+  sink_.close(ec);
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
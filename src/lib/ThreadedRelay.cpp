@@ -0,0 +1,291 @@
+#include <yandex/contest/invoker/flowctl/interactive/ThreadedRelay.hpp>
+
+#include "RelayUtility.hpp"
+
+#include <yandex/contest/StreamLog.hpp>
+#include <yandex/contest/SystemError.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+constexpr std::size_t ThreadedRelay::DEFAULT_BUFFER_SIZE;
+
+namespace {
+system::unistd::Descriptor makeEventFd() {
+  const int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fd < 0) BOOST_THROW_EXCEPTION(SystemError("eventfd"));
+  return system::unistd::Descriptor(fd);
+}
+
+void setNonBlocking(const int fd) {
+  const int flags = ::fcntl(fd, F_GETFL);
+  if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    BOOST_THROW_EXCEPTION(SystemError("fcntl"));
+}
+}  // namespace
+
+struct ThreadedRelay::Notifier {
+  Notifier(boost::asio::io_service &ioService, const Handler &readHandler,
+           const Handler &writeHandler)
+      : ioService(ioService),
+        readHandler(readHandler),
+        writeHandler(writeHandler) {}
+
+  /// Queue size bytes, posts a call unless one is already queued.
+  void notify(std::atomic<std::size_t> &pending, const Handler &handler,
+              const std::size_t size, const std::shared_ptr<Notifier> &self) {
+    if (pending.fetch_add(size)) return;
+    ioService.post([self, &pending, &handler] {
+      const std::size_t size = pending.exchange(0);
+      if (self->alive && size) handler(boost::system::error_code(), size);
+    });
+  }
+
+  void error(const Handler &handler, const boost::system::error_code &ec,
+             const std::shared_ptr<Notifier> &self) {
+    ioService.post([self, &handler, ec] {
+      if (self->alive) handler(ec, 0);
+    });
+  }
+
+  /// Threads keep io_service running.
+  void finished(const std::shared_ptr<Notifier> &self) {
+    if (--running) return;
+    ioService.post([self] { self->work.reset(); });
+  }
+
+  boost::asio::io_service &ioService;
+  const Handler readHandler;
+  const Handler writeHandler;
+  std::atomic<std::size_t> pendingRead{0};
+  std::atomic<std::size_t> pendingWrite{0};
+  std::atomic<bool> alive{true};
+  std::atomic<int> running{0};
+  std::unique_ptr<boost::asio::io_service::work> work;
+};
+
+ThreadedRelay::ThreadedRelay(Connection &source, Connection &sink,
+                             const Handler &readHandler,
+                             const Handler &writeHandler,
+                             const std::size_t bufferSize)
+    : source_(source),
+      sink_(sink),
+      notifier_(std::make_shared<Notifier>(source.get_io_service(),
+                                           readHandler, writeHandler)),
+      buffer_(bufferSize) {
+  reader_.wakeup = makeEventFd();
+  writer_.wakeup = makeEventFd();
+}
+
+ThreadedRelay::~ThreadedRelay() {
+  stopThreads();
+  notifier_->alive = false;
+}
+
+void ThreadedRelay::setCloseSinkOnEof(const bool closeSinkOnEof) {
+  closeSinkOnEof_ = closeSinkOnEof;
+}
+
+void ThreadedRelay::setDiscardOnSinkError(const bool discardOnSinkError) {
+  discardOnSinkError_ = discardOnSinkError;
+}
+
+void ThreadedRelay::start() {
+  setNonBlocking(source_.native_handle());
+  setNonBlocking(sink_.native_handle());
+  notifier_->work.reset(
+      new boost::asio::io_service::work(notifier_->ioService));
+  notifier_->running = 2;
+  readerThread_ = std::thread(&ThreadedRelay::readLoop, this);
+  writerThread_ = std::thread(&ThreadedRelay::writeLoop, this);
+}
+
+void ThreadedRelay::close() {
+  closing_ = true;
+  interrupt(reader_);
+}
+
+void ThreadedRelay::terminate() {
+  stopThreads();
+  boost::system::error_code ec;
+  source_.close(ec);
+  sink_.close(ec);
+}
+
+void ThreadedRelay::stopThreads() {
+  stopping_ = true;
+  interrupt(reader_);
+  interrupt(writer_);
+  if (readerThread_.joinable()) readerThread_.join();
+  if (writerThread_.joinable()) writerThread_.join();
+}
+
+void ThreadedRelay::readLoop() {
+  try {
+    const int fd = source_.native_handle();
+    while (!stopping_ && !closing_) {
+      iovec parts[2];
+      const int count = buffer_.writable(parts);
+      if (!count) {
+        sleep(reader_, -1, 0, [this] {
+          return !buffer_.full() || stopping_ || closing_;
+        });
+        continue;
+      }
+
+      const ssize_t size = ::readv(fd, parts, count);
+      if (size > 0) {
+        if (readDataHandler_) callDataHandler(readDataHandler_, parts, size);
+        buffer_.produce(size);
+        wake(writer_);
+        notifier_->notify(notifier_->pendingRead, notifier_->readHandler,
+                          size, notifier_);
+        if ((bytesRead_ += size) > readLimit_) break;
+      } else if (size == 0) {
+        notifier_->error(notifier_->readHandler, boost::asio::error::eof,
+                         notifier_);
+        break;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        sleep(reader_, fd, POLLIN, [] { return false; });
+      } else if (errno != EINTR) {
+        notifier_->error(notifier_->readHandler, lastError(), notifier_);
+        break;
+      }
+    }
+
+    if (readDataHandler_) readDataHandler_(nullptr, 0);
+  } catch (...) {
+    fail(std::current_exception());
+  }
+
+  sourceDone_ = true;
+  wake(writer_);
+  notifier_->finished(notifier_);
+}
+
+void ThreadedRelay::writeLoop() {
+  try {
+    const int fd = sink_.native_handle();
+    bool sinkFailed = false;
+    while (!stopping_) {
+      iovec parts[2];
+      const int count = buffer_.readable(parts);
+      if (!count) {
+        if (sourceDone_) {
+          // reader may have produced data right before it has finished
+          if (buffer_.empty()) break;
+          continue;
+        }
+        sleep(writer_, -1, 0, [this] {
+          return !buffer_.empty() || sourceDone_ || stopping_;
+        });
+        continue;
+      }
+
+      const std::size_t available =
+          parts[0].iov_len + (count > 1 ? parts[1].iov_len : 0);
+      if (sinkFailed) {
+        buffer_.consume(available);
+        wake(reader_);
+        continue;
+      }
+
+      const ssize_t size = ::writev(fd, parts, count);
+      if (size > 0) {
+        if (writeDataHandler_)
+          callDataHandler(writeDataHandler_, parts, size);
+        buffer_.consume(size);
+        wake(reader_);
+        bytesWritten_ += size;
+        notifier_->notify(notifier_->pendingWrite, notifier_->writeHandler,
+                          size, notifier_);
+      } else if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        sleep(writer_, fd, POLLOUT, [] { return false; });
+      } else if (size < 0 && errno != EINTR) {
+        notifier_->error(notifier_->writeHandler, lastError(), notifier_);
+        if (!discardOnSinkError_) {
+          stopping_ = true;
+          interrupt(reader_);
+          break;
+        }
+        sinkFailed = true;
+      }
+    }
+
+    if (writeDataHandler_) writeDataHandler_(nullptr, 0);
+  } catch (...) {
+    fail(std::current_exception());
+  }
+
+  if (!stopping_ && (closeSinkOnEof_ || closing_)) {
+    // connection is owned by io_service thread
+    Connection &sink = sink_;
+    const std::shared_ptr<Notifier> notifier = notifier_;
+    notifier_->ioService.post([notifier, &sink] {
+      boost::system::error_code ec;
+      if (notifier->alive) sink.close(ec);
+    });
+  }
+  notifier_->finished(notifier_);
+}
+
+void ThreadedRelay::fail(const std::exception_ptr error) {
+  boost::system::error_code ec =
+      boost::system::errc::make_error_code(boost::system::errc::io_error);
+  try {
+    std::rethrow_exception(error);
+  } catch (boost::system::system_error &e) {
+    STREAM_ERROR << "Data handler has failed: " << e.what();
+    ec = e.code();
+  } catch (std::exception &e) {
+    STREAM_ERROR << "Data handler has failed: " << e.what();
+  } catch (...) {
+    STREAM_ERROR << "Data handler has failed with unknown exception";
+  }
+
+  stopping_ = true;
+  interrupt(reader_);
+  interrupt(writer_);
+  notifier_->error(notifier_->readHandler, ec, notifier_);
+}
+
+template <typename Predicate>
+void ThreadedRelay::sleep(Side &side, const int fd, const short events,
+                          const Predicate &ready) {
+  side.waiting.store(true);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!ready() && !stopping_) {
+    pollfd fds[2] = {{side.wakeup.get(), POLLIN, 0}, {fd, events, 0}};
+    ::poll(fds, fd < 0 ? 1 : 2, -1);
+  }
+  side.waiting.store(false);
+  std::uint64_t value;
+  while (::read(side.wakeup.get(), &value, sizeof(value)) > 0) continue;
+}
+
+void ThreadedRelay::wake(Side &side) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (side.waiting.load()) interrupt(side);
+}
+
+void ThreadedRelay::interrupt(Side &side) {
+  const std::uint64_t value = 1;
+  if (::write(side.wakeup.get(), &value, sizeof(value)) < 0) {
+    // eventfd counter overflow only, thread is awake anyway
+  }
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,328 @@
+#include <yandex/contest/invoker/flowctl/interactive/UringRelay.hpp>
+
+#include <yandex/contest/StreamLog.hpp>
+#include <yandex/contest/SystemError.hpp>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+namespace {
+boost::system::error_code makeError(const int result) {
+  return boost::system::error_code(-result, boost::system::system_category());
+}
+
+void setBlocking(Relay::Connection &connection) {
+  const int fd = connection.native_handle();
+  const int flags = ::fcntl(fd, F_GETFL);
+  if (flags >= 0 && (flags & O_NONBLOCK))
+    ::fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+}
+}  // namespace
+
+UringLoop::UringLoop(boost::asio::io_service &ioService, const unsigned entries,
+                     const std::size_t bufferCount,
+                     const std::size_t bufferSize)
+    : bufferSize_(bufferSize), ring_(entries), event_(ioService) {
+  const int eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (eventFd < 0) BOOST_THROW_EXCEPTION(SystemError("eventfd"));
+  event_.assign(eventFd);
+  ring_.registerEventFd(eventFd);
+
+  std::vector<iovec> iovecs(bufferCount);
+  for (std::size_t i = 0; i < bufferCount; ++i) {
+    buffers_.emplace_back(new char[bufferSize_]);
+    iovecs[i].iov_base = buffers_.back().get();
+    iovecs[i].iov_len = bufferSize_;
+  }
+  ring_.registerBuffers(iovecs.data(), iovecs.size());
+}
+
+io_uring_sqe *UringLoop::getSqe(Operation *const operation) {
+  io_uring_sqe *sqe = ring_.getSqe();
+  if (!sqe) {
+    ring_.submit();
+    sqe = ring_.getSqe();
+  }
+  BOOST_ASSERT(sqe);
+  sqe->user_data = reinterpret_cast<std::uintptr_t>(operation);
+  ++inFlight_;
+  if (operation) pending_.push_back(operation);
+  return sqe;
+}
+
+void UringLoop::cancel(Operation &operation) {
+  io_uring_sqe *const sqe = getSqe(nullptr);
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<std::uintptr_t>(&operation);
+}
+
+void UringLoop::submit() {
+  ring_.submit();
+  if (inFlight_ && !waiting_ && event_.is_open()) wait();
+}
+
+void UringLoop::wait() {
+  waiting_ = true;
+  event_.async_read_some(
+      boost::asio::buffer(&eventValue_, sizeof(eventValue_)),
+      boost::bind(&UringLoop::handle_event, this,
+                  boost::asio::placeholders::error));
+}
+
+void UringLoop::close() {
+  boost::system::error_code ec;
+  event_.close(ec);
+}
+
+void UringLoop::handle_event(const boost::system::error_code &ec) {
+  // loop may be already destroyed
+  if (ec == boost::asio::error::operation_aborted) return;
+  waiting_ = false;
+
+  // completions posted before the error are still valid
+  drain();
+  if (ec) {
+    fail(ec);
+    return;
+  }
+
+  if (inFlight_ && !waiting_ && event_.is_open()) wait();
+}
+
+void UringLoop::drain() {
+  io_uring_cqe cqe;
+  while (ring_.popCompletion(cqe)) {
+    --inFlight_;
+    if (!cqe.user_data) continue;
+    Operation *const operation = reinterpret_cast<Operation *>(cqe.user_data);
+    // the same operation may be resubmitted before its cancellation
+    const auto pending = std::find(pending_.begin(), pending_.end(), operation);
+    if (pending != pending_.end()) pending_.erase(pending);
+    operation->complete(cqe.res);
+  }
+}
+
+void UringLoop::fail(const boost::system::error_code &ec) {
+  STREAM_ERROR << "Unable to wait for io_uring completions: " << ec.message()
+               << ", failing " << pending_.size() << " operations";
+  close();
+
+  const int result =
+      ec.category() == boost::system::system_category() ? -ec.value() : -EIO;
+  // operations submitted by failed ones are failed as well
+  while (!pending_.empty()) {
+    Operation *const operation = pending_.front();
+    pending_.erase(pending_.begin());
+    --inFlight_;
+    operation->complete(result);
+  }
+}
+
+UringRelay::UringRelay(UringLoop &loop, const std::size_t bufferIndex,
+                       Connection &source, Connection &sink,
+                       const Handler &readHandler, const Handler &writeHandler)
+    : loop_(loop),
+      bufferIndex_(bufferIndex),
+      buffer_(loop.buffer(bufferIndex)),
+      source_(source),
+      sink_(sink),
+      readHandler_(readHandler),
+      writeHandler_(writeHandler) {}
+
+void UringRelay::setCloseSinkOnEof(const bool closeSinkOnEof) {
+  closeSinkOnEof_ = closeSinkOnEof;
+}
+
+void UringRelay::setDiscardOnSinkError(const bool discardOnSinkError) {
+  discardOnSinkError_ = discardOnSinkError;
+}
+
+void UringRelay::start() {
+  // io_uring waits for blocking files only
+  setBlocking(source_);
+  setBlocking(sink_);
+
+  prepareRead();
+  loop_.submit();
+}
+
+void UringRelay::close() {
+  closing_ = true;
+  // pending data is flushed by handle_write()
+  if (!writes_) finish();
+}
+
+void UringRelay::terminate() { finish(); }
+
+void UringRelay::prepareRead() {
+  io_uring_sqe *const sqe = loop_.getSqe(&readOperation_);
+  sqe->opcode = IORING_OP_READ_FIXED;
+  sqe->fd = source_.native_handle();
+  sqe->addr = reinterpret_cast<std::uintptr_t>(buffer_);
+  sqe->len = loop_.bufferSize();
+  sqe->buf_index = bufferIndex_;
+  ++reads_;
+}
+
+void UringRelay::prepareWrite(const bool link) {
+  io_uring_sqe *const sqe = loop_.getSqe(&writeOperation_);
+  sqe->opcode = IORING_OP_WRITE_FIXED;
+  sqe->fd = sink_.native_handle();
+  sqe->addr = reinterpret_cast<std::uintptr_t>(buffer_ + written_);
+  sqe->len = size_ - written_;
+  sqe->buf_index = bufferIndex_;
+  if (link) sqe->flags |= IOSQE_IO_LINK;
+  ++writes_;
+}
+
+void UringRelay::preparePoll(const int fd, const short events) {
+  io_uring_sqe *const sqe = loop_.getSqe(&pollOperation_);
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll_events = events;
+  sqe->flags |= IOSQE_IO_LINK;
+  pollEvents_ = events;
+  ++polls_;
+}
+
+void UringRelay::handle_read(const int result) {
+  --reads_;
+  // canceled reads are resubmitted by handle_write()
+  if (finished_ || result == -ECANCELED) return;
+
+  if (result == -EAGAIN) {
+    preparePoll(source_.native_handle(), POLLIN);
+    prepareRead();
+    loop_.submit();
+    return;
+  }
+
+  if (result == -EINTR) {
+    prepareRead();
+    loop_.submit();
+    return;
+  }
+
+  if (result < 0) {
+    readHandler_(makeError(result), 0);
+    finish();
+    return;
+  }
+
+  if (!result) {
+    readHandler_(boost::asio::error::eof, 0);
+    if (closeSinkOnEof_ || closing_) finish();
+    return;
+  }
+
+  size_ = result;
+  written_ = 0;
+  if (readDataHandler_) readDataHandler_(buffer_, size_);
+  readHandler_(boost::system::error_code(), size_);
+  if (finished_) return;
+
+  if (sinkFailed_) {
+    if (closing_) {
+      finish();
+    } else {
+      prepareRead();
+      loop_.submit();
+    }
+    return;
+  }
+
+  // next read starts only if the whole chunk is written
+  prepareWrite(!closing_);
+  if (!closing_) prepareRead();
+  loop_.submit();
+}
+
+void UringRelay::handle_write(const int result) {
+  --writes_;
+  if (finished_ || result == -ECANCELED) return;
+
+  if (result == -EAGAIN || result == -EINTR) {
+    if (result == -EAGAIN) preparePoll(sink_.native_handle(), POLLOUT);
+    prepareWrite(!closing_);
+    if (!closing_) prepareRead();
+    loop_.submit();
+    return;
+  }
+
+  if (result < 0) {
+    // linked read is canceled
+    sinkFailed_ = true;
+    writeHandler_(makeError(result), 0);
+    if (finished_) return;
+    if (discardOnSinkError_ && !closing_) {
+      prepareRead();
+      loop_.submit();
+    } else {
+      finish();
+    }
+    return;
+  }
+
+  if (writeDataHandler_) writeDataHandler_(buffer_ + written_, result);
+  written_ += result;
+  writeHandler_(boost::system::error_code(), result);
+  if (finished_) return;
+
+  if (written_ < size_) {
+    // short write breaks the link, so read is canceled
+    prepareWrite(!closing_);
+    if (!closing_) prepareRead();
+    loop_.submit();
+    return;
+  }
+
+  if (closing_) finish();
+}
+
+void UringRelay::handle_poll(const int result) {
+  --polls_;
+  if (finished_ || result >= 0 || result == -ECANCELED) return;
+
+  // linked operations are canceled and will not be resubmitted
+  if (pollEvents_ & POLLIN)
+    readHandler_(makeError(result), 0);
+  else
+    writeHandler_(makeError(result), 0);
+  finish();
+}
+
+void UringRelay::finish() {
+  if (finished_) return;
+  finished_ = true;
+
+  if (reads_) loop_.cancel(readOperation_);
+  if (writes_) loop_.cancel(writeOperation_);
+  if (polls_) loop_.cancel(pollOperation_);
+  loop_.submit();
+
+  if (readDataHandler_) readDataHandler_(nullptr, 0);
+  if (writeDataHandler_) writeDataHandler_(nullptr, 0);
+
+  boost::system::error_code ec;
+  source_.close(ec);
+  sink_.close(ec);
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
@@ -0,0 +1,193 @@
+#include <yandex/contest/invoker/flowctl/interactive/VectoredRelay.hpp>
+
+#include "RelayUtility.hpp"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#include <sys/uio.h>
+
+namespace yandex {
+namespace contest {
+namespace invoker {
+namespace flowctl {
+namespace interactive {
+
+constexpr std::size_t VectoredRelay::DEFAULT_BUFFER_SIZE;
+
+VectoredRelay::VectoredRelay(Connection &source, Connection &sink,
+                             const Handler &readHandler,
+                             const Handler &writeHandler,
+                             const std::size_t bufferSize)
+    : source_(source),
+      sink_(sink),
+      readHandler_(readHandler),
+      writeHandler_(writeHandler),
+      buffer_(bufferSize) {}
+
+void VectoredRelay::setCloseSinkOnEof(const bool closeSinkOnEof) {
+  closeSinkOnEof_ = closeSinkOnEof;
+}
+
+void VectoredRelay::setDiscardOnSinkError(const bool discardOnSinkError) {
+  discardOnSinkError_ = discardOnSinkError;
+}
+
+void VectoredRelay::start() {
+  source_.non_blocking(true);
+  sink_.non_blocking(true);
+  pump();
+}
+
+void VectoredRelay::close() {
+  closing_ = true;
+  if (sourceWaiting_) {
+    boost::system::error_code ec;
+    source_.cancel(ec);
+  }
+  pump();
+}
+
+void VectoredRelay::terminate() { finish(); }
+
+void VectoredRelay::pump() {
+  // handlers may close relay while it is pumping
+  if (pumping_ || finished_) return;
+  pumping_ = true;
+  while (!finished_) {
+    const bool read = drain();
+    const bool written = flush();
+    if (!read && !written) break;
+  }
+  pumping_ = false;
+  if (finished_) return;
+
+  if ((sourceDone_ || closing_) && buffer_.empty()) {
+    if (closeSinkOnEof_ || closing_) finish();
+    return;
+  }
+
+  if (sourceBlocked_ && !sourceWaiting_ && !sourceDone_ && !closing_) {
+    sourceWaiting_ = true;
+    source_.async_read_some(
+        boost::asio::null_buffers(),
+        boost::bind(&VectoredRelay::handle_source_ready, this,
+                    boost::asio::placeholders::error));
+  }
+
+  if (sinkBlocked_ && !sinkWaiting_) {
+    sinkWaiting_ = true;
+    sink_.async_write_some(
+        boost::asio::null_buffers(),
+        boost::bind(&VectoredRelay::handle_sink_ready, this,
+                    boost::asio::placeholders::error));
+  }
+}
+
+bool VectoredRelay::drain() {
+  const int fd = source_.native_handle();
+  bool read = false;
+  while (!sourceBlocked_ && !sourceDone_ && !closing_ && !finished_) {
+    iovec parts[2];
+    const int count = buffer_.writable(parts);
+    if (!count) break;
+
+    const ssize_t size = ::readv(fd, parts, count);
+    if (size > 0) {
+      read = true;
+      if (readDataHandler_) callDataHandler(readDataHandler_, parts, size);
+      buffer_.produce(size);
+      readHandler_(boost::system::error_code(), size);
+    } else if (size == 0) {
+      sourceDone_ = true;
+      readHandler_(boost::asio::error::eof, 0);
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      sourceBlocked_ = true;
+    } else if (errno != EINTR) {
+      readHandler_(lastError(), 0);
+      finish();
+    }
+  }
+  return read;
+}
+
+bool VectoredRelay::flush() {
+  const int fd = sink_.native_handle();
+  bool written = false;
+  while (!sinkBlocked_ && !finished_) {
+    iovec parts[2];
+    const int count = buffer_.readable(parts);
+    if (!count) break;
+
+    if (sinkFailed_) {
+      buffer_.consume(buffer_.size());
+      written = true;
+      continue;
+    }
+
+    const ssize_t size = ::writev(fd, parts, count);
+    if (size >= 0) {
+      written = true;
+      if (writeDataHandler_) callDataHandler(writeDataHandler_, parts, size);
+      buffer_.consume(size);
+      writeHandler_(boost::system::error_code(), size);
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      sinkBlocked_ = true;
+    } else if (errno != EINTR) {
+      sinkFailed_ = true;
+      writeHandler_(lastError(), 0);
+      if (!discardOnSinkError_) finish();
+    }
+  }
+  return written;
+}
+
+void VectoredRelay::handle_source_ready(const boost::system::error_code &ec) {
+  sourceWaiting_ = false;
+  if (finished_ || ec == boost::asio::error::operation_aborted) return;
+
+  if (ec) {
+    readHandler_(ec, 0);
+    finish();
+    return;
+  }
+
+  sourceBlocked_ = false;
+  pump();
+}
+
+void VectoredRelay::handle_sink_ready(const boost::system::error_code &ec) {
+  sinkWaiting_ = false;
+  if (finished_ || ec == boost::asio::error::operation_aborted) return;
+
+  if (ec) {
+    sinkFailed_ = true;
+    writeHandler_(ec, 0);
+    if (!discardOnSinkError_) {
+      finish();
+      return;
+    }
+  }
+
+  sinkBlocked_ = false;
+  pump();
+}
+
+void VectoredRelay::finish() {
+  if (finished_) return;
+  finished_ = true;
+
+  if (readDataHandler_) readDataHandler_(nullptr, 0);
+  if (writeDataHandler_) writeDataHandler_(nullptr, 0);
+
+  boost::system::error_code ec;
+  source_.close(ec);
+  sink_.close(ec);
+}
+
+}  // namespace interactive
+}  // namespace flowctl
+}  // namespace invoker
+}  // namespace contest
+}  // namespace yandex
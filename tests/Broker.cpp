@@ -0,0 +1,202 @@
+#define BOOST_TEST_MODULE Broker
+#include <boost/test/unit_test.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/Broker.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/BinaryCommandIo.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+namespace ya = yandex::contest;
+namespace yai = ya::invoker::flowctl::interactive;
+
+namespace {
+void writeAll(const int fd, const std::string &data) {
+  std::size_t pos = 0;
+  while (pos < data.size()) {
+    const ssize_t size = ::write(fd, data.data() + pos, data.size() - pos);
+    BOOST_REQUIRE_GT(size, 0);
+    pos += size;
+  }
+}
+
+std::string readAll(const int fd) {
+  std::string data;
+  char buffer[4096];
+  ssize_t size;
+  while ((size = ::read(fd, buffer, sizeof(buffer))) > 0)
+    data.append(buffer, size);
+  return data;
+}
+
+std::string binaryRequest(const yai::CommandSet &commands,
+                          const std::string &payload) {
+  std::string data;
+  yai::appendEncodedBinaryCommandPack(commands, data);
+  char size[yai::MAX_VARINT_SIZE];
+  data.append(size, yai::encodeVarintTo(payload.size(), size));
+  return data + payload;
+}
+
+struct BrokerFixture {
+  /// Peer ends, broker ends are owned by broker.
+  BrokerFixture() {
+    makePipe(interactorBroker, options.interactorBrokerFd, false);
+    makePipe(brokerInteractor, options.brokerInteractorFd, true);
+    makePipe(solutionBroker, options.solutionBrokerFd, false);
+    makePipe(brokerSolution, options.brokerSolutionFd, true);
+    options.requestDelimiter = "\n";
+    options.responseDelimiter = "\n";
+  }
+
+  ~BrokerFixture() {
+    for (const int fd :
+         {interactorBroker, brokerInteractor, solutionBroker, brokerSolution})
+      if (fd >= 0) ::close(fd);
+  }
+
+  static void makePipe(int &peer, int &broker, const bool brokerWrites) {
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(::pipe(fds), 0);
+    broker = fds[brokerWrites ? 1 : 0];
+    peer = fds[brokerWrites ? 0 : 1];
+  }
+
+  static void closeFd(int &fd) {
+    ::close(fd);
+    fd = -1;
+  }
+
+  /// Whole conversation fits into pipe buffers.
+  yai::Broker::Status run(const std::string &requests,
+                          const std::string &responses) {
+    writeAll(interactorBroker, requests);
+    closeFd(interactorBroker);
+    writeAll(solutionBroker, responses);
+    closeFd(solutionBroker);
+    const yai::Broker::Status status = yai::Broker(options).run();
+    interactorOutput = readAll(brokerInteractor);
+    solutionInput = readAll(brokerSolution);
+    return status;
+  }
+
+  yai::Broker::Options options;
+  int interactorBroker = -1;
+  int brokerInteractor = -1;
+  int solutionBroker = -1;
+  int brokerSolution = -1;
+
+  std::string interactorOutput;
+  std::string solutionInput;
+};
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(Broker, BrokerFixture)
+
+BOOST_AUTO_TEST_CASE(pipelined) {
+  options.responseMultiplier = 2;
+  BOOST_CHECK_EQUAL(run("1\n2\n3\n", "a\nb\nc\nd\ne\nf\n"), yai::Broker::OK);
+  BOOST_CHECK_EQUAL(solutionInput, "1\n2\n3\n");
+  BOOST_CHECK_EQUAL(interactorOutput, "a\nb\nc\nd\ne\nf\n");
+}
+
+BOOST_AUTO_TEST_CASE(responses_span_reads) {
+  options.responseDelimiter = "\r\n";
+  options.responseMultiplier = 3;
+  writeAll(interactorBroker, "1\n2\n");
+  closeFd(interactorBroker);
+
+  // every byte is a separate read, delimiters are split
+  const std::string responses = "a\r\nbb\r\nc\r\nd\r\ne\r\nf\r\n";
+  std::thread solution([this, &responses] {
+    for (const char c : responses) {
+      writeAll(solutionBroker, std::string(1, c));
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    closeFd(solutionBroker);
+  });
+  const yai::Broker::Status status = yai::Broker(options).run();
+  solution.join();
+
+  BOOST_CHECK_EQUAL(status, yai::Broker::OK);
+  BOOST_CHECK_EQUAL(readAll(brokerSolution), "1\n2\n");
+  BOOST_CHECK_EQUAL(readAll(brokerInteractor), responses);
+}
+
+BOOST_AUTO_TEST_CASE(zero_multiplier) {
+  options.responseMultiplier = 0;
+  BOOST_CHECK_EQUAL(run("1\n2\n", ""), yai::Broker::OK);
+  BOOST_CHECK_EQUAL(solutionInput, "1\n2\n");
+  BOOST_CHECK_EQUAL(interactorOutput, "");
+}
+
+BOOST_AUTO_TEST_CASE(zero_multiplier_command) {
+  options.requestCommands = true;
+  BOOST_CHECK_EQUAL(run("RESPONSE_MULTIPLIER=0;1\n"
+                        "RESPONSE_MULTIPLIER=2;2\n"
+                        "RESPONSE_MULTIPLIER=0;3\n"
+                        ";4\n",
+                        "a\nb\nc\n"),
+                    yai::Broker::OK);
+  BOOST_CHECK_EQUAL(solutionInput, "1\n2\n3\n4\n");
+  BOOST_CHECK_EQUAL(interactorOutput, "a\nb\nc\n");
+}
+
+BOOST_AUTO_TEST_CASE(solution_eof_inside_batch) {
+  options.responseMultiplier = 3;
+  BOOST_CHECK_EQUAL(run("1\n", "a\nb\n"),
+                    yai::Broker::SOLUTION_INSUFFICIENT_DATA);
+  BOOST_CHECK_EQUAL(interactorOutput, "");
+}
+
+BOOST_AUTO_TEST_CASE(solution_excess_data) {
+  BOOST_CHECK_EQUAL(run("1\n", "a\nb\n"), yai::Broker::SOLUTION_EXCESS_DATA);
+  BOOST_CHECK_EQUAL(interactorOutput, "a\n");
+}
+
+BOOST_AUTO_TEST_CASE(interactor_eof_inside_request) {
+  BOOST_CHECK_EQUAL(run("1\n2", "a\n"),
+                    yai::Broker::INTERACTOR_INSUFFICIENT_DATA);
+  BOOST_CHECK_EQUAL(solutionInput, "1\n");
+}
+
+BOOST_AUTO_TEST_CASE(binary_header_spans_reads) {
+  options.binaryCommands = true;
+  yai::CommandSet commands;
+  commands.insert(yai::OK_VERDICT_CUSTOM, std::string(1000, 'x'));
+  commands.insert(yai::RESPONSE_MULTIPLIER, "2");
+  const std::string request = binaryRequest(commands, "1\n");
+  writeAll(solutionBroker, "a\nb\n");
+  closeFd(solutionBroker);
+
+  // header arrives in many small reads
+  std::thread interactor([this, &request] {
+    for (std::size_t pos = 0; pos < request.size(); pos += 100) {
+      writeAll(interactorBroker, request.substr(pos, 100));
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    closeFd(interactorBroker);
+  });
+  const yai::Broker::Status status = yai::Broker(options).run();
+  interactor.join();
+
+  BOOST_CHECK_EQUAL(status, yai::Broker::OK);
+  BOOST_CHECK_EQUAL(readAll(brokerSolution), "1\n");
+  BOOST_CHECK_EQUAL(readAll(brokerInteractor), "a\nb\n");
+}
+
+BOOST_AUTO_TEST_CASE(binary_header_limit) {
+  options.binaryCommands = true;
+  options.maxHeaderSize = 64;
+  yai::CommandSet commands;
+  commands.insert(yai::OK_VERDICT_CUSTOM, std::string(100, 'x'));
+  BOOST_CHECK_EQUAL(run(binaryRequest(commands, "1\n"), ""),
+                    yai::Broker::INTERACTOR_INVALID_COMMAND);
+  BOOST_CHECK_EQUAL(solutionInput, "");
+}
+
+BOOST_AUTO_TEST_SUITE_END()  // Broker
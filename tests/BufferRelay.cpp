@@ -0,0 +1,300 @@
+#define BOOST_TEST_MODULE BufferRelay
+#include <boost/test/unit_test.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/BufferRelay.hpp>
+
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ya = yandex::contest;
+namespace yai = ya::invoker::flowctl::interactive;
+
+namespace {
+struct Transfer {
+  std::size_t calls = 0;
+  std::size_t bytes = 0;
+
+  /// The first error reported.
+  boost::system::error_code error;
+};
+
+yai::Relay::Handler capture(Transfer &transfer) {
+  return [&transfer](const boost::system::error_code &ec,
+                     const std::size_t size) {
+    ++transfer.calls;
+    transfer.bytes += size;
+    if (ec && !transfer.error) transfer.error = ec;
+  };
+}
+
+/// Delay is never reached by a test.
+yai::BufferRelay::CoalescingOptions withoutDeadline() {
+  yai::BufferRelay::CoalescingOptions options;
+  options.delay = std::chrono::seconds(60);
+  return options;
+}
+
+struct BufferRelayFixture {
+  /// Relay reads from peer's source and writes into peer's sink.
+  BufferRelayFixture() : source(ioService), sink(ioService) {
+    // broken pipe is reported by write
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(::pipe(fds), 0);
+    source.assign(fds[0]);
+    peerSource = fds[1];
+    BOOST_REQUIRE_EQUAL(::pipe2(fds, O_NONBLOCK), 0);
+    peerSink = fds[0];
+    sink.assign(fds[1]);
+  }
+
+  ~BufferRelayFixture() {
+    if (peerSource >= 0) ::close(peerSource);
+    if (peerSink >= 0) ::close(peerSink);
+  }
+
+  void send(const std::string &data) {
+    BOOST_REQUIRE_EQUAL(::write(peerSource, data.data(), data.size()),
+                        static_cast<ssize_t>(data.size()));
+  }
+
+  static void closeFd(int &fd) {
+    ::close(fd);
+    fd = -1;
+  }
+
+  /// Read everything available from peer's sink.
+  void receive() {
+    if (peerSink < 0) return;
+    char buffer[4096];
+    ssize_t size;
+    while ((size = ::read(peerSink, buffer, sizeof(buffer))) > 0)
+      received.append(buffer, size);
+    if (!size) peerSinkEof = true;
+  }
+
+  /// Run ready handlers until predicate holds, false on timeout.
+  template <typename Predicate>
+  bool runUntil(const Predicate predicate) {
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    for (;;) {
+      ioService.poll();
+      ioService.reset();
+      receive();
+      if (predicate()) return true;
+      if (std::chrono::steady_clock::now() > deadline) return false;
+      std::this_thread::yield();
+    }
+  }
+
+  boost::asio::io_service ioService;
+  yai::Relay::Connection source;
+  yai::Relay::Connection sink;
+  int peerSource = -1;
+  int peerSink = -1;
+
+  Transfer read, write;
+  std::string received;
+  bool peerSinkEof = false;
+};
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(BufferRelay, BufferRelayFixture)
+
+BOOST_AUTO_TEST_CASE(buffer_growth) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write), 4);
+  relay.setMaxBufferSize(16);
+  relay.start();
+
+  // read which does not fill the buffer does not grow it
+  send("ab");
+  BOOST_REQUIRE(runUntil([this] { return received.size() == 2; }));
+  BOOST_CHECK_EQUAL(relay.bufferSize(), 4);
+
+  std::string data;
+  for (std::size_t i = 0; i < 100; ++i) data.push_back('a' + i % 26);
+  send(data);
+  BOOST_REQUIRE(
+      runUntil([&] { return received.size() == data.size() + 2; }));
+  BOOST_CHECK_EQUAL(received, "ab" + data);
+  BOOST_CHECK_EQUAL(relay.bufferSize(), 16);
+  BOOST_CHECK_EQUAL(read.bytes, data.size() + 2);
+  BOOST_CHECK_EQUAL(write.bytes, data.size() + 2);
+  BOOST_CHECK(!read.error);
+  BOOST_CHECK(!write.error);
+}
+
+BOOST_AUTO_TEST_CASE(eof_closes_sink) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  relay.start();
+  send("data");
+  closeFd(peerSource);
+  BOOST_REQUIRE(runUntil([this] { return peerSinkEof; }));
+  BOOST_CHECK_EQUAL(received, "data");
+  BOOST_CHECK_EQUAL(read.error, boost::asio::error::eof);
+  BOOST_CHECK(!source.is_open());
+  BOOST_CHECK(!sink.is_open());
+}
+
+BOOST_AUTO_TEST_CASE(eof_keeps_sink) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  relay.setCloseSinkOnEof(false);
+  relay.start();
+  send("data");
+  closeFd(peerSource);
+  BOOST_REQUIRE(runUntil([this] { return read.error && received == "data"; }));
+  BOOST_CHECK_EQUAL(read.error, boost::asio::error::eof);
+  BOOST_CHECK(sink.is_open());
+  BOOST_CHECK(!peerSinkEof);
+
+  relay.close();
+  BOOST_REQUIRE(runUntil([this] { return peerSinkEof; }));
+  BOOST_CHECK_EQUAL(received, "data");
+}
+
+BOOST_AUTO_TEST_CASE(discard_on_sink_error) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  relay.setDiscardOnSinkError(true);
+  relay.start();
+  closeFd(peerSink);
+  send("abc");
+  BOOST_REQUIRE(runUntil([this] { return write.error; }));
+  BOOST_CHECK_EQUAL(write.error, boost::asio::error::broken_pipe);
+
+  // source is still drained
+  send("def");
+  closeFd(peerSource);
+  BOOST_REQUIRE(runUntil([this] { return read.error; }));
+  BOOST_CHECK_EQUAL(read.error, boost::asio::error::eof);
+  BOOST_CHECK_EQUAL(read.bytes, 6);
+  BOOST_CHECK_EQUAL(write.bytes, 0);
+  BOOST_CHECK_EQUAL(write.calls, 1);
+  BOOST_CHECK(!source.is_open());
+}
+
+BOOST_AUTO_TEST_CASE(sink_error) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  relay.start();
+  closeFd(peerSink);
+  send("abc");
+  BOOST_REQUIRE(runUntil([this] { return write.error; }));
+  BOOST_CHECK_EQUAL(write.error, boost::asio::error::broken_pipe);
+  BOOST_CHECK(!source.is_open());
+  BOOST_CHECK(!sink.is_open());
+}
+
+BOOST_AUTO_TEST_CASE(close) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  relay.start();
+  send("abc");
+  BOOST_REQUIRE(runUntil([this] { return read.bytes == 3; }));
+
+  relay.close();
+  BOOST_REQUIRE(runUntil([this] { return peerSinkEof; }));
+  BOOST_CHECK_EQUAL(received, "abc");
+  // canceled read is not reported
+  BOOST_CHECK(!read.error);
+  BOOST_CHECK(!source.is_open());
+}
+
+BOOST_AUTO_TEST_CASE(terminate) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  bool dataEnd = false;
+  relay.setReadDataHandler([&dataEnd](const char *const data, std::size_t) {
+    if (!data) dataEnd = true;
+  });
+  relay.start();
+  relay.terminate();
+  BOOST_CHECK(dataEnd);
+  BOOST_CHECK(!source.is_open());
+  BOOST_CHECK(!sink.is_open());
+
+  BOOST_REQUIRE(runUntil([this] { return peerSinkEof; }));
+  BOOST_CHECK_EQUAL(read.calls, 0);
+  BOOST_CHECK_EQUAL(write.calls, 0);
+}
+
+BOOST_AUTO_TEST_SUITE(coalescing)
+
+BOOST_AUTO_TEST_CASE(threshold) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  auto options = withoutDeadline();
+  options.threshold = 4;
+  relay.setCoalescing(options);
+  relay.start();
+
+  send("ab");
+  BOOST_REQUIRE(runUntil([this] { return read.bytes == 2; }));
+  BOOST_CHECK_EQUAL(write.calls, 0);
+  BOOST_CHECK_EQUAL(received, "");
+
+  send("cd");
+  BOOST_REQUIRE(runUntil([this] { return received == "abcd"; }));
+  BOOST_CHECK_EQUAL(write.calls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(delimiter) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  auto options = withoutDeadline();
+  options.delimiter = '\n';
+  relay.setCoalescing(options);
+  relay.start();
+
+  send("ab");
+  BOOST_REQUIRE(runUntil([this] { return read.bytes == 2; }));
+  send("c");
+  BOOST_REQUIRE(runUntil([this] { return read.bytes == 3; }));
+  BOOST_CHECK_EQUAL(received, "");
+
+  send("\n");
+  BOOST_REQUIRE(runUntil([this] { return received == "abc\n"; }));
+  BOOST_CHECK_EQUAL(write.calls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(deadline) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  yai::BufferRelay::CoalescingOptions options;
+  options.delay = std::chrono::milliseconds(20);
+  relay.setCoalescing(options);
+  relay.start();
+
+  // neither threshold nor delimiter is reached
+  const auto begin = std::chrono::steady_clock::now();
+  send("ab");
+  BOOST_REQUIRE(runUntil([this] { return received == "ab"; }));
+  BOOST_CHECK(std::chrono::steady_clock::now() - begin >= options.delay);
+  // pending read was canceled to flush, it is not reported
+  BOOST_CHECK(!read.error);
+
+  // and restarted
+  send("cd");
+  BOOST_REQUIRE(runUntil([this] { return received == "abcd"; }));
+  BOOST_CHECK(!read.error);
+  BOOST_CHECK_EQUAL(read.bytes, 4);
+}
+
+BOOST_AUTO_TEST_CASE(eof) {
+  yai::BufferRelay relay(source, sink, capture(read), capture(write));
+  relay.setCoalescing(withoutDeadline());
+  relay.start();
+
+  send("ab");
+  BOOST_REQUIRE(runUntil([this] { return read.bytes == 2; }));
+  BOOST_CHECK_EQUAL(received, "");
+
+  closeFd(peerSource);
+  BOOST_REQUIRE(runUntil([this] { return peerSinkEof; }));
+  BOOST_CHECK_EQUAL(received, "ab");
+  BOOST_CHECK_EQUAL(read.error, boost::asio::error::eof);
+}
+
+BOOST_AUTO_TEST_SUITE_END()  // coalescing
+
+BOOST_AUTO_TEST_SUITE_END()  // BufferRelay
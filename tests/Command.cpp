@@ -1,9 +1,16 @@
 #define BOOST_TEST_MODULE Command
 #include <boost/test/unit_test.hpp>
 
+#include <yandex/contest/invoker/flowctl/interactive/BinaryCommandIo.hpp>
 #include <yandex/contest/invoker/flowctl/interactive/Command.hpp>
 #include <yandex/contest/invoker/flowctl/interactive/CommandIo.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/CommandPackDecoder.hpp>
 #include <yandex/contest/invoker/flowctl/interactive/Error.hpp>
+#include <yandex/contest/invoker/flowctl/interactive/PercentEncoding.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <random>
 
 namespace ya = yandex::contest;
 namespace yai = ya::invoker::flowctl::interactive;
@@ -33,6 +40,68 @@ BOOST_AUTO_TEST_CASE(value) {
 
   BOOST_CHECK_THROW(dec("hello%IsNotADigit"),
                     yai::DecodeCommandValueDigitExpectedError);
+
+  BOOST_CHECK_EQUAL(enc("a.b"), "a%2eb");
+  BOOST_CHECK_EQUAL(dec("a%2eb"), "a.b");
+  BOOST_CHECK_EQUAL(dec("a%2Eb"), "a.b");
+}
+
+BOOST_AUTO_TEST_CASE(percent_encoding) {
+  using Implementation = yai::PercentEncoding::Implementation;
+
+  std::mt19937 generator(0);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    std::string value(generator() % 100, '\0');
+    for (char &c : value)
+      c = generator() % 4 ? 'a' + generator() % 26 : generator();
+    const std::string encoded = yai::encodeCommandValue(value);
+
+    for (const Implementation implementation :
+         {Implementation::SCALAR, Implementation::SSE2, Implementation::AVX2}) {
+      if (!yai::PercentEncoding::isSupported(implementation)) continue;
+      const yai::PercentEncoding encoding(implementation);
+
+      std::string data(3 * value.size(), '\0');
+      data.resize(encoding.encode(value.data(), value.size(), &data[0]));
+      BOOST_CHECK_EQUAL(data, encoded);
+
+      std::string decoded(data.size(), '\0');
+      std::size_t size = 0;
+      boost::system::error_code ec;
+      BOOST_CHECK_EQUAL(
+          encoding.decode(data.data(), data.size(), &decoded[0], size, ec),
+          data.size());
+      BOOST_CHECK(!ec);
+      decoded.resize(size);
+      BOOST_CHECK_EQUAL(decoded, value);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(buffers) {
+  using namespace yai;
+
+  const Command command = makeCommand(ERROR_VERDICT_CUSTOM, "x = 1");
+  std::string buffer(maxEncodedCommandSize(command), '\0');
+  buffer.resize(encodeCommandTo(command, &buffer[0]));
+  BOOST_CHECK_EQUAL(buffer, "ERROR_VERDICT_CUSTOM=x%20%3d%201");
+
+  std::string data = "prefix ";
+  appendEncodedCommandValue("a b", data);
+  BOOST_CHECK_EQUAL(data, "prefix a%20b");
+
+  Command decoded;
+  boost::system::error_code ec;
+  BOOST_CHECK_EQUAL(decodeCommandTo(buffer, decoded, ec), buffer.size());
+  BOOST_CHECK(!ec);
+  BOOST_CHECK(decoded == command);
+
+  BOOST_CHECK_EQUAL(decodeCommandTo("UNKNOWN", decoded, ec), 0);
+  BOOST_CHECK(ec == CommandIoErrc::UNKNOWN_COMMAND_NAME);
+
+  std::string value;
+  BOOST_CHECK_EQUAL(decodeCommandValueTo("ab%zz", value, ec), 3);
+  BOOST_CHECK(ec == CommandIoErrc::DIGIT_EXPECTED);
 }
 
 BOOST_AUTO_TEST_CASE(command) {
@@ -50,13 +119,36 @@ BOOST_AUTO_TEST_CASE(command) {
                     makeCommand(RESPONSE_MULTIPLIER, "10"));
 
   BOOST_CHECK_THROW(dec("RESPONSE_MULTIPLIER=10="), DecodeCommandError);
+  BOOST_CHECK_THROW(dec("REQUEST=1"), DecodeCommandError);
+}
+
+BOOST_AUTO_TEST_CASE(command_name) {
+  using namespace yai;
+
+  for (const CommandName name :
+       {REQUEST, EMPTY_REQUEST, LAST_REQUEST, EOF_REQUEST, RESPONSE,
+        LAST_RESPONSE, EMPTY_RESPONSE, EOF_RESPONSE, CLOSE, OK_VERDICT,
+        OK_VERDICT_CUSTOM, ERROR_VERDICT, ERROR_VERDICT_CUSTOM,
+        RESPONSE_MULTIPLIER}) {
+    const std::string string = boost::lexical_cast<std::string>(name);
+    BOOST_CHECK_EQUAL(commandNameString(name), string);
+    CommandName parsed = CLOSE;
+    BOOST_CHECK(parseCommandName(string, parsed));
+    BOOST_CHECK_EQUAL(parsed, name);
+  }
+
+  CommandName name;
+  for (const char *const string :
+       {"", "R", "REQUESTS", "REQUESX", "XEQUEST", "request", "CLOSE_",
+        "EMPTY_REQUESX", "ERROR_VERDICX"})
+    BOOST_CHECK(!parseCommandName(string, name));
 }
 
 BOOST_AUTO_TEST_CASE(pack) {
   using namespace yai;
 
-  const auto enc = &encodeCommandPack;
-  const auto dec = &decodeCommandPack;
+  std::string (*const enc)(const CommandPack &) = &encodeCommandPack;
+  CommandPack (*const dec)(const std::string &) = &decodeCommandPack;
 
   {
     const CommandPack pack = {makeCommand(REQUEST), makeCommand(LAST_RESPONSE),
@@ -69,6 +161,129 @@ BOOST_AUTO_TEST_CASE(pack) {
     BOOST_CHECK_EQUAL(enc(pack), data);
     BOOST_CHECK(dec(data) == pack);
   }
+
+  // flags have no value, as in command_set
+  BOOST_CHECK(dec("REQUEST=;") == CommandPack{makeCommand(REQUEST)});
+  BOOST_CHECK_THROW(dec("REQUEST=1;"), DecodeCommandPackError);
+}
+
+BOOST_AUTO_TEST_CASE(command_set) {
+  using namespace yai;
+
+  const CommandPack pack = {makeCommand(REQUEST), makeCommand(LAST_RESPONSE),
+                            makeCommand(OK_VERDICT_CUSTOM, "a b"),
+                            makeCommand(RESPONSE_MULTIPLIER, "10")};
+  const std::string data =
+      "REQUEST&"
+      "LAST_RESPONSE&"
+      "OK_VERDICT_CUSTOM=a%20b&"
+      "RESPONSE_MULTIPLIER=10;";
+
+  const CommandSet set(pack);
+  BOOST_CHECK_EQUAL(set.size(), 4);
+  BOOST_CHECK(set.contains(LAST_RESPONSE));
+  BOOST_CHECK(!set.contains(RESPONSE));
+  BOOST_CHECK_EQUAL(set.value(RESPONSE_MULTIPLIER), "10");
+  BOOST_CHECK(set.toCommandPack() == pack);
+  BOOST_CHECK_EQUAL(encodeCommandPack(set), data);
+
+  CommandSet decoded;
+  decoded.parameter(ERROR_VERDICT) = "stale";
+  decodeCommandPack(data, decoded);
+  BOOST_CHECK(decoded == set);
+  BOOST_CHECK(!decoded.contains(ERROR_VERDICT));
+
+  decodeCommandPack("REQUEST=;", decoded);
+  BOOST_CHECK(decoded.contains(REQUEST));
+  BOOST_CHECK_THROW(decodeCommandPack("REQUEST=1;", decoded),
+                    DecodeCommandPackError);
+}
+
+BOOST_AUTO_TEST_CASE(binary) {
+  using namespace yai;
+
+  char varint[MAX_VARINT_SIZE];
+  for (const std::uint64_t value :
+       {std::uint64_t(0), std::uint64_t(0x7F), std::uint64_t(0x80),
+        std::uint64_t(300), ~std::uint64_t(0)}) {
+    const std::size_t size = encodeVarintTo(value, varint);
+    std::uint64_t decoded;
+    boost::system::error_code ec;
+    BOOST_CHECK_EQUAL(decodeVarint(StringRef(varint, size), decoded, ec),
+                      size);
+    BOOST_CHECK(!ec);
+    BOOST_CHECK_EQUAL(decoded, value);
+  }
+
+  CommandSet set;
+  set.insert(REQUEST);
+  set.insert(OK_VERDICT_CUSTOM, std::string("a\0;&b", 5));
+  set.insert(RESPONSE_MULTIPLIER, "10");
+  std::string data;
+  appendEncodedBinaryCommandPack(set, data);
+  BOOST_CHECK(isBinaryCommandPack(data));
+  BOOST_CHECK(!isBinaryCommandPack(encodeCommandPack(set)));
+
+  CommandSet decoded;
+  boost::system::error_code ec;
+  BOOST_CHECK_EQUAL(decodeBinaryCommandPackTo(data + "tail", decoded, ec),
+                    data.size());
+  BOOST_CHECK(!ec);
+  BOOST_CHECK(decoded == set);
+
+  // truncated pack reports how much data is needed to continue
+  for (std::size_t size = 0; size < data.size(); ++size) {
+    const std::size_t required =
+        decodeBinaryCommandPackTo(data.substr(0, size), decoded, ec);
+    BOOST_CHECK(ec == CommandIoErrc::INSUFFICIENT_DATA);
+    BOOST_CHECK_GT(required, size);
+    BOOST_CHECK_LE(required, data.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(pack_decoder) {
+  using namespace yai;
+
+  CommandPack pack;
+  CommandPackDecoder decoder(
+      [&pack](const CommandName name, const std::string &value) {
+        pack.emplace(name, value);
+      });
+
+  const std::string data =
+      "REQUEST&"
+      "ERROR_VERDICT_CUSTOM=hello%20world%2e&"
+      "RESPONSE_MULTIPLIER=10;"
+      "payload";
+  const CommandPack expected = {
+      makeCommand(REQUEST), makeCommand(ERROR_VERDICT_CUSTOM, "hello world."),
+      makeCommand(RESPONSE_MULTIPLIER, "10")};
+
+  // whole pack at once
+  BOOST_CHECK_EQUAL(decoder.feed(data.data(), data.size()),
+                    data.size() - std::string("payload").size());
+  BOOST_CHECK(decoder.complete());
+  BOOST_CHECK(pack == expected);
+
+  // byte by byte
+  pack.clear();
+  decoder.reset();
+  std::size_t consumed = 0;
+  while (!decoder.complete()) {
+    BOOST_REQUIRE_LT(consumed, data.size());
+    consumed += decoder.feed(data.data() + consumed, 1);
+  }
+  BOOST_CHECK_EQUAL(data.substr(consumed), "payload");
+  BOOST_CHECK(pack == expected);
+
+  decoder.reset();
+  BOOST_CHECK_THROW(decoder.feed("UNKNOWN;", 8), DecodeCommandError);
+  decoder.reset();
+  BOOST_CHECK_THROW(decoder.feed("REQUEST=%x;", 11),
+                    DecodeCommandValueDigitExpectedError);
+  decoder.reset();
+  BOOST_CHECK_THROW(decoder.feed("REQUEST=a b;", 12),
+                    DecodeCommandValueCharacterIsNotPermittedError);
 }
 
 BOOST_AUTO_TEST_SUITE_END()  // Io
@@ -0,0 +1,56 @@
+#define BOOST_TEST_MODULE DelimiterSearch
+#include <boost/test/unit_test.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/DelimiterSearch.hpp>
+
+#include <random>
+
+namespace ya = yandex::contest;
+namespace yai = ya::invoker::flowctl::interactive;
+
+using Implementation = yai::DelimiterSearch::Implementation;
+
+BOOST_AUTO_TEST_SUITE(DelimiterSearch_)
+
+BOOST_AUTO_TEST_CASE(simple) {
+  for (const Implementation implementation :
+       {Implementation::SCALAR, Implementation::SSE2, Implementation::AVX2}) {
+    if (!yai::DelimiterSearch::isSupported(implementation)) continue;
+    BOOST_TEST_MESSAGE(implementation);
+
+    const yai::DelimiterSearch newline("\n", implementation);
+    const std::string line = std::string(100, 'a') + "\n";
+    BOOST_CHECK_EQUAL(newline.find(line.data(), line.size()), 100);
+    BOOST_CHECK_EQUAL(newline.find(line.data(), 100),
+                      yai::DelimiterSearch::npos);
+    BOOST_CHECK_EQUAL(newline.find(line.data(), 0),
+                      yai::DelimiterSearch::npos);
+
+    const yai::DelimiterSearch crlf("\r\n", implementation);
+    const std::string data = std::string(40, '\r') + "\r\n";
+    BOOST_CHECK_EQUAL(crlf.find(data.data(), data.size()), 40);
+    BOOST_CHECK_EQUAL(crlf.find(data.data(), data.size() - 1),
+                      yai::DelimiterSearch::npos);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(random) {
+  std::mt19937 generator(0);
+  for (std::size_t i = 0; i < 10000; ++i) {
+    std::string delimiter(1 + generator() % 5, '\0');
+    for (char &c : delimiter) c = "ab"[generator() % 2];
+    std::string data(generator() % 200, '\0');
+    for (char &c : data) c = "abc"[generator() % 3];
+    const std::size_t expected = data.find(delimiter);
+
+    for (const Implementation implementation :
+         {Implementation::SCALAR, Implementation::SSE2,
+          Implementation::AVX2}) {
+      if (!yai::DelimiterSearch::isSupported(implementation)) continue;
+      const yai::DelimiterSearch search(delimiter, implementation);
+      BOOST_CHECK_EQUAL(search.find(data.data(), data.size()), expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()  // DelimiterSearch_
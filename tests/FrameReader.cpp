@@ -0,0 +1,188 @@
+#define BOOST_TEST_MODULE FrameReader
+#include <boost/test/unit_test.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/FrameReader.hpp>
+
+#include <boost/optional.hpp>
+
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ya = yandex::contest;
+namespace yai = ya::invoker::flowctl::interactive;
+
+namespace {
+struct Result {
+  boost::optional<boost::system::error_code> ec;
+  std::string data;
+};
+
+yai::FrameReader::Handler capture(Result &result) {
+  result = Result();
+  return [&result](const boost::system::error_code &ec, const char *data,
+                   const std::size_t size) {
+    result.ec = ec;
+    result.data.assign(data, size);
+  };
+}
+
+struct FrameReaderFixture {
+  FrameReaderFixture() : source(ioService) {
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    source.assign(fds[0]);
+    peer = fds[1];
+  }
+
+  ~FrameReaderFixture() {
+    if (peer >= 0) ::close(peer);
+  }
+
+  void send(const std::string &data) {
+    BOOST_REQUIRE_EQUAL(::write(peer, data.data(), data.size()),
+                        static_cast<ssize_t>(data.size()));
+  }
+
+  void closePeer() {
+    ::close(peer);
+    peer = -1;
+  }
+
+  /// Run every handler that is ready, never blocks.
+  void poll() {
+    ioService.poll();
+    ioService.reset();
+  }
+
+  boost::asio::io_service ioService;
+  yai::FrameReader::Connection source;
+  int peer = -1;
+};
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(FrameReader, FrameReaderFixture)
+
+BOOST_AUTO_TEST_CASE(delimiter_split) {
+  yai::FrameReader reader(source, "\r\n");
+  Result result;
+  reader.async_read_frame(capture(result));
+  send("ab\r");
+  poll();
+  BOOST_CHECK(!result.ec);
+
+  send("\ncd");
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK(!*result.ec);
+  BOOST_CHECK_EQUAL(result.data, "ab\r\n");
+
+  reader.async_read_frame(capture(result));
+  send("\r");
+  poll();
+  BOOST_CHECK(!result.ec);
+  send("\n");
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK(!*result.ec);
+  BOOST_CHECK_EQUAL(result.data, "cd\r\n");
+}
+
+BOOST_AUTO_TEST_CASE(frames_span_reads) {
+  yai::FrameReader reader(source, "\n");
+  Result result;
+  reader.async_read_frames(3, capture(result));
+  send("a\nb");
+  poll();
+  BOOST_CHECK(!result.ec);
+  send("\nc");
+  poll();
+  BOOST_CHECK(!result.ec);
+  send("\nd\ne");
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK(!*result.ec);
+  BOOST_CHECK_EQUAL(result.data, "a\nb\nc\n");
+
+  // already buffered, no read is needed
+  reader.async_read_frame(capture(result));
+  BOOST_CHECK(!result.ec);
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK(!*result.ec);
+  BOOST_CHECK_EQUAL(result.data, "d\n");
+}
+
+BOOST_AUTO_TEST_CASE(zero_frames) {
+  yai::FrameReader reader(source, "\n");
+  Result result;
+  send("a\n");
+  reader.async_read_frames(0, capture(result));
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK(!*result.ec);
+  BOOST_CHECK_EQUAL(result.data, "");
+
+  reader.async_read_frame(capture(result));
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK_EQUAL(result.data, "a\n");
+}
+
+BOOST_AUTO_TEST_CASE(eof_inside_batch) {
+  yai::FrameReader reader(source, "\n");
+  Result result;
+  reader.async_read_frames(2, capture(result));
+  send("a\nb");
+  closePeer();
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK_EQUAL(*result.ec, boost::asio::error::eof);
+  BOOST_CHECK_EQUAL(result.data, "a\nb");
+}
+
+BOOST_AUTO_TEST_CASE(eof_at_boundary) {
+  yai::FrameReader reader(source, "\n");
+  Result result;
+  send("a\n");
+  closePeer();
+  reader.async_read_frame(capture(result));
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK(!*result.ec);
+  BOOST_CHECK_EQUAL(result.data, "a\n");
+
+  reader.async_read_frame(capture(result));
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK_EQUAL(*result.ec, boost::asio::error::eof);
+  BOOST_CHECK_EQUAL(result.data, "");
+}
+
+BOOST_AUTO_TEST_CASE(peek_and_chunk) {
+  yai::FrameReader reader(source, "\n");
+  Result result;
+  reader.async_peek(3, capture(result));
+  send("ab");
+  poll();
+  BOOST_CHECK(!result.ec);
+  send("c\n");
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK(!*result.ec);
+  BOOST_CHECK_EQUAL(result.data, "abc\n");
+
+  // peeked data is not consumed
+  reader.async_read_chunk(2, capture(result));
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK_EQUAL(result.data, "ab");
+
+  reader.async_read_frame(capture(result));
+  poll();
+  BOOST_REQUIRE(result.ec);
+  BOOST_CHECK_EQUAL(result.data, "c\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()  // FrameReader
@@ -0,0 +1,159 @@
+#define BOOST_TEST_MODULE InProcessPipe
+#include <boost/test/unit_test.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/InProcessPipe.hpp>
+
+#include <boost/optional.hpp>
+
+#include <string>
+
+namespace ya = yandex::contest;
+namespace yai = ya::invoker::flowctl::interactive;
+
+namespace {
+struct Result {
+  boost::optional<boost::system::error_code> ec;
+  std::size_t size = 0;
+};
+
+yai::InProcessPipe::Handler capture(Result &result) {
+  result = Result();
+  return [&result](const boost::system::error_code &ec,
+                   const std::size_t size) {
+    result.ec = ec;
+    result.size = size;
+  };
+}
+
+struct InProcessPipeFixture {
+  InProcessPipeFixture() : pipe(ioService) {}
+
+  void run() {
+    ioService.run();
+    ioService.reset();
+  }
+
+  boost::asio::io_service ioService;
+  yai::InProcessPipe pipe;
+};
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(InProcessPipe, InProcessPipeFixture)
+
+BOOST_AUTO_TEST_CASE(transfer) {
+  const std::string data = "hello world";
+  std::string buffer(data.size(), '\0');
+  Result write, read;
+  boost::asio::async_write(pipe.writeEnd(), boost::asio::buffer(data),
+                           capture(write));
+  // reader's buffer is smaller, write is completed in parts
+  boost::asio::async_read(pipe.readEnd(), boost::asio::buffer(&buffer[0], 4),
+                          capture(read));
+  run();
+  BOOST_REQUIRE(read.ec);
+  BOOST_CHECK(!*read.ec);
+  BOOST_CHECK_EQUAL(read.size, 4);
+  BOOST_CHECK(!write.ec);
+
+  boost::asio::async_read(pipe.readEnd(),
+                          boost::asio::buffer(&buffer[4], data.size() - 4),
+                          capture(read));
+  run();
+  BOOST_REQUIRE(read.ec);
+  BOOST_CHECK(!*read.ec);
+  BOOST_CHECK_EQUAL(read.size, data.size() - 4);
+  BOOST_REQUIRE(write.ec);
+  BOOST_CHECK(!*write.ec);
+  BOOST_CHECK_EQUAL(write.size, data.size());
+  BOOST_CHECK_EQUAL(buffer, data);
+}
+
+BOOST_AUTO_TEST_CASE(close_write_while_reading) {
+  char buffer[16];
+  Result read;
+  pipe.readEnd().async_read_some(boost::asio::buffer(buffer), capture(read));
+  run();
+  BOOST_CHECK(!read.ec);
+
+  pipe.writeEnd().close();
+  run();
+  BOOST_REQUIRE(read.ec);
+  BOOST_CHECK_EQUAL(*read.ec, boost::asio::error::eof);
+  BOOST_CHECK_EQUAL(read.size, 0);
+
+  // every following read is at eof
+  pipe.readEnd().async_read_some(boost::asio::buffer(buffer), capture(read));
+  run();
+  BOOST_REQUIRE(read.ec);
+  BOOST_CHECK_EQUAL(*read.ec, boost::asio::error::eof);
+}
+
+BOOST_AUTO_TEST_CASE(close_read_while_writing) {
+  const std::string data = "data";
+  Result write;
+  pipe.writeEnd().async_write_some(boost::asio::buffer(data), capture(write));
+  run();
+  BOOST_CHECK(!write.ec);
+
+  pipe.readEnd().close();
+  run();
+  BOOST_REQUIRE(write.ec);
+  BOOST_CHECK_EQUAL(*write.ec, boost::asio::error::broken_pipe);
+  BOOST_CHECK_EQUAL(write.size, 0);
+  BOOST_CHECK(!pipe.readEnd().is_open());
+
+  pipe.writeEnd().async_write_some(boost::asio::buffer(data), capture(write));
+  run();
+  BOOST_REQUIRE(write.ec);
+  BOOST_CHECK_EQUAL(*write.ec, boost::asio::error::broken_pipe);
+
+  char buffer[16];
+  Result read;
+  pipe.readEnd().async_read_some(boost::asio::buffer(buffer), capture(read));
+  run();
+  BOOST_REQUIRE(read.ec);
+  BOOST_CHECK_EQUAL(*read.ec, boost::asio::error::bad_descriptor);
+}
+
+BOOST_AUTO_TEST_CASE(cancel) {
+  char buffer[16];
+  Result read;
+  pipe.readEnd().async_read_some(boost::asio::buffer(buffer), capture(read));
+  pipe.readEnd().cancel();
+  run();
+  BOOST_REQUIRE(read.ec);
+  BOOST_CHECK_EQUAL(*read.ec, boost::asio::error::operation_aborted);
+  BOOST_CHECK(pipe.readEnd().is_open());
+}
+
+BOOST_AUTO_TEST_CASE(empty_buffers) {
+  Result write, read;
+  pipe.writeEnd().async_write_some(boost::asio::const_buffer(),
+                                   capture(write));
+  pipe.readEnd().async_read_some(boost::asio::mutable_buffer(),
+                                 capture(read));
+  run();
+  BOOST_REQUIRE(write.ec);
+  BOOST_CHECK(!*write.ec);
+  BOOST_CHECK_EQUAL(write.size, 0);
+  BOOST_REQUIRE(read.ec);
+  BOOST_CHECK(!*read.ec);
+  BOOST_CHECK_EQUAL(read.size, 0);
+
+  // empty write does not satisfy a pending read
+  char buffer[16];
+  pipe.readEnd().async_read_some(boost::asio::buffer(buffer), capture(read));
+  boost::asio::async_write(pipe.writeEnd(), boost::asio::const_buffer(),
+                           capture(write));
+  run();
+  BOOST_REQUIRE(write.ec);
+  BOOST_CHECK(!*write.ec);
+  BOOST_CHECK(!read.ec);
+
+  pipe.writeEnd().close();
+  run();
+  BOOST_REQUIRE(read.ec);
+  BOOST_CHECK_EQUAL(*read.ec, boost::asio::error::eof);
+}
+
+BOOST_AUTO_TEST_SUITE_END()  // InProcessPipe
@@ -0,0 +1,154 @@
+#define BOOST_TEST_MODULE ThreadedRelay
+#include <boost/test/unit_test.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/ThreadedRelay.hpp>
+
+#include <chrono>
+#include <csignal>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ya = yandex::contest;
+namespace yai = ya::invoker::flowctl::interactive;
+
+namespace {
+struct Transfer {
+  std::size_t calls = 0;
+  std::size_t bytes = 0;
+
+  /// The first error reported.
+  boost::system::error_code error;
+};
+
+yai::Relay::Handler capture(Transfer &transfer) {
+  return [&transfer](const boost::system::error_code &ec,
+                     const std::size_t size) {
+    ++transfer.calls;
+    transfer.bytes += size;
+    if (ec && !transfer.error) transfer.error = ec;
+  };
+}
+
+struct ThreadedRelayFixture {
+  /// Relay reads from peer's source and writes into peer's sink.
+  ThreadedRelayFixture() : source(ioService), sink(ioService) {
+    // broken pipe is reported by write
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(::pipe(fds), 0);
+    source.assign(fds[0]);
+    peerSource = fds[1];
+    BOOST_REQUIRE_EQUAL(::pipe2(fds, O_NONBLOCK), 0);
+    peerSink = fds[0];
+    sink.assign(fds[1]);
+  }
+
+  ~ThreadedRelayFixture() {
+    if (peerSource >= 0) ::close(peerSource);
+    if (peerSink >= 0) ::close(peerSink);
+  }
+
+  void send(const std::string &data) {
+    BOOST_REQUIRE_EQUAL(::write(peerSource, data.data(), data.size()),
+                        static_cast<ssize_t>(data.size()));
+  }
+
+  static void closeFd(int &fd) {
+    ::close(fd);
+    fd = -1;
+  }
+
+  /// Read everything available from peer's sink.
+  void receive() {
+    if (peerSink < 0) return;
+    char buffer[4096];
+    ssize_t size;
+    while ((size = ::read(peerSink, buffer, sizeof(buffer))) > 0)
+      received.append(buffer, size);
+    if (!size) peerSinkEof = true;
+  }
+
+  /// Run handlers posted by relay threads until predicate holds.
+  template <typename Predicate>
+  bool runUntil(const Predicate predicate) {
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    for (;;) {
+      ioService.poll();
+      ioService.reset();
+      receive();
+      if (predicate()) return true;
+      if (std::chrono::steady_clock::now() > deadline) return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  boost::asio::io_service ioService;
+  yai::Relay::Connection source;
+  yai::Relay::Connection sink;
+  int peerSource = -1;
+  int peerSink = -1;
+
+  Transfer read, write;
+  std::string received;
+  bool peerSinkEof = false;
+};
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(ThreadedRelay, ThreadedRelayFixture)
+
+BOOST_AUTO_TEST_CASE(eof_closes_sink) {
+  yai::ThreadedRelay relay(source, sink, capture(read), capture(write), 8);
+  relay.start();
+
+  std::string data;
+  for (std::size_t i = 0; i < 100; ++i) data.push_back('a' + i % 26);
+  send(data);
+  closeFd(peerSource);
+  BOOST_REQUIRE(runUntil([this] { return peerSinkEof; }));
+  BOOST_CHECK_EQUAL(received, data);
+  BOOST_CHECK_EQUAL(read.error, boost::asio::error::eof);
+  BOOST_CHECK(!write.error);
+  BOOST_CHECK_EQUAL(relay.bytesRead(), data.size());
+  BOOST_CHECK_EQUAL(relay.bytesWritten(), data.size());
+  BOOST_CHECK(!sink.is_open());
+}
+
+BOOST_AUTO_TEST_CASE(read_limit) {
+  yai::ThreadedRelay relay(source, sink, capture(read), capture(write), 8);
+  relay.setReadLimit(16);
+  const std::string data(64, 'x');
+  send(data);
+  relay.start();
+
+  // everything read before limit is exceeded is still written
+  BOOST_REQUIRE(runUntil([this] { return peerSinkEof; }));
+  BOOST_CHECK_GT(relay.bytesRead(), 16);
+  BOOST_CHECK_LE(relay.bytesRead(), 16 + 8);
+  BOOST_CHECK_EQUAL(received, data.substr(0, relay.bytesRead()));
+  BOOST_CHECK_EQUAL(read.bytes, relay.bytesRead());
+  BOOST_CHECK(!read.error);
+}
+
+BOOST_AUTO_TEST_CASE(data_handler_error) {
+  yai::ThreadedRelay relay(source, sink, capture(read), capture(write));
+  relay.setReadDataHandler([](const char *const data, std::size_t) {
+    if (data) throw std::runtime_error("data handler");
+  });
+  relay.start();
+  send("abc");
+
+  // nothing is rethrown from io_service
+  BOOST_REQUIRE(runUntil([this] { return read.error; }));
+  BOOST_CHECK_EQUAL(read.error, boost::system::errc::io_error);
+  BOOST_CHECK_EQUAL(relay.bytesRead(), 0);
+  BOOST_CHECK_EQUAL(write.calls, 0);
+  BOOST_CHECK_EQUAL(received, "");
+}
+
+BOOST_AUTO_TEST_SUITE_END()  // ThreadedRelay
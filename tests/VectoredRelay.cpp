@@ -0,0 +1,151 @@
+#define BOOST_TEST_MODULE VectoredRelay
+#include <boost/test/unit_test.hpp>
+
+#include <yandex/contest/invoker/flowctl/interactive/VectoredRelay.hpp>
+
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ya = yandex::contest;
+namespace yai = ya::invoker::flowctl::interactive;
+
+namespace {
+struct Transfer {
+  std::size_t calls = 0;
+  std::size_t bytes = 0;
+
+  /// The first error reported.
+  boost::system::error_code error;
+};
+
+yai::Relay::Handler capture(Transfer &transfer) {
+  return [&transfer](const boost::system::error_code &ec,
+                     const std::size_t size) {
+    ++transfer.calls;
+    transfer.bytes += size;
+    if (ec && !transfer.error) transfer.error = ec;
+  };
+}
+
+struct VectoredRelayFixture {
+  /// Relay reads from peer's source and writes into peer's sink.
+  VectoredRelayFixture() : source(ioService), sink(ioService) {
+    // broken pipe is reported by write
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(::pipe(fds), 0);
+    source.assign(fds[0]);
+    peerSource = fds[1];
+    BOOST_REQUIRE_EQUAL(::pipe2(fds, O_NONBLOCK), 0);
+    peerSink = fds[0];
+    sink.assign(fds[1]);
+  }
+
+  ~VectoredRelayFixture() {
+    if (peerSource >= 0) ::close(peerSource);
+    if (peerSink >= 0) ::close(peerSink);
+  }
+
+  void send(const std::string &data) {
+    BOOST_REQUIRE_EQUAL(::write(peerSource, data.data(), data.size()),
+                        static_cast<ssize_t>(data.size()));
+  }
+
+  static void closeFd(int &fd) {
+    ::close(fd);
+    fd = -1;
+  }
+
+  /// Read everything available from peer's sink.
+  void receive() {
+    if (peerSink < 0) return;
+    char buffer[4096];
+    ssize_t size;
+    while ((size = ::read(peerSink, buffer, sizeof(buffer))) > 0)
+      received.append(buffer, size);
+    if (!size) peerSinkEof = true;
+  }
+
+  /// Run ready handlers until predicate holds, false on timeout.
+  template <typename Predicate>
+  bool runUntil(const Predicate predicate) {
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    for (;;) {
+      ioService.poll();
+      ioService.reset();
+      receive();
+      if (predicate()) return true;
+      if (std::chrono::steady_clock::now() > deadline) return false;
+      std::this_thread::yield();
+    }
+  }
+
+  boost::asio::io_service ioService;
+  yai::Relay::Connection source;
+  yai::Relay::Connection sink;
+  int peerSource = -1;
+  int peerSink = -1;
+
+  Transfer read, write;
+  std::string received;
+  bool peerSinkEof = false;
+};
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(VectoredRelay, VectoredRelayFixture)
+
+BOOST_AUTO_TEST_CASE(eof_closes_sink) {
+  yai::VectoredRelay relay(source, sink, capture(read), capture(write), 8);
+  relay.start();
+
+  std::string data;
+  for (std::size_t i = 0; i < 100; ++i) data.push_back('a' + i % 26);
+  send(data);
+  closeFd(peerSource);
+  BOOST_REQUIRE(runUntil([this] { return peerSinkEof; }));
+  BOOST_CHECK_EQUAL(received, data);
+  BOOST_CHECK_EQUAL(read.error, boost::asio::error::eof);
+  BOOST_CHECK_EQUAL(read.bytes, data.size());
+  BOOST_CHECK_EQUAL(write.bytes, data.size());
+  BOOST_CHECK(!write.error);
+  BOOST_CHECK(!source.is_open());
+  BOOST_CHECK(!sink.is_open());
+}
+
+BOOST_AUTO_TEST_CASE(output_limit) {
+  // limit is enforced by read handler, as BufferedConnection does
+  std::unique_ptr<yai::VectoredRelay> relay;
+  const yai::Relay::Handler count = capture(read);
+  relay.reset(new yai::VectoredRelay(
+      source, sink,
+      [&](const boost::system::error_code &ec, const std::size_t size) {
+        count(ec, size);
+        if (read.bytes > 16) relay->terminate();
+      },
+      capture(write), 8));
+  const std::string data(64, 'x');
+  send(data);
+  relay->start();
+
+  BOOST_REQUIRE(runUntil([this] { return peerSinkEof; }));
+  const std::size_t calls = read.calls;
+  BOOST_CHECK_GT(read.bytes, 16);
+  BOOST_CHECK_LE(read.bytes, 16 + 8);
+  BOOST_CHECK_EQUAL(received, data.substr(0, write.bytes));
+  BOOST_CHECK(!source.is_open());
+
+  // remaining data is never read
+  BOOST_CHECK(runUntil([] { return true; }));
+  BOOST_CHECK_EQUAL(read.calls, calls);
+  BOOST_CHECK(!read.error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()  // VectoredRelay